@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdint.h>
+#include <vec/vec.h>
+
+// Bump allocator over a chain of chunks. Individual allocations are never
+// freed; ArenaRelease rolls back to a mark and ArenaReset empties the arena
+// while keeping its first chunk for reuse.
+
+typedef struct ArenaChunk ArenaChunk;
+
+typedef struct {
+  ArenaChunk* chunk;
+  char* cursor;
+  char* limit;
+  char* last;
+  uint64_t chunk_size;
+  VecAllocator allocator;
+} Arena;
+
+typedef struct {
+  ArenaChunk* chunk;
+  char* cursor;
+} ArenaMark;
+
+#define ARENA_DEFAULT_CHUNK_SIZE (1024 * 1024)
+
+void ArenaInit(Arena* arena, uint64_t chunk_size);
+void ArenaFree(Arena* arena);
+
+void* ArenaAlloc(Arena* arena, uint64_t size);
+// Grows the most recent allocation in place when it fits, otherwise copies.
+void* ArenaRealloc(Arena* arena,
+                   void* ptr,
+                   uint64_t old_size,
+                   uint64_t new_size);
+
+ArenaMark ArenaGetMark(const Arena* arena);
+void ArenaRelease(Arena* arena, ArenaMark mark);
+void ArenaReset(Arena* arena);
+
+// Allocator for vecs whose storage should live in `arena`. The arena must not
+// move while vecs use it.
+const VecAllocator* ArenaVecAllocator(Arena* arena);
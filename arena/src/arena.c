@@ -0,0 +1,144 @@
+#include "arena/arena.h"
+
+#include <stdalign.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_ALIGN alignof(max_align_t)
+
+struct ArenaChunk {
+  ArenaChunk* prev;
+  uint64_t size;
+  alignas(ARENA_ALIGN) char data[];
+};
+
+static bool ArenaGrow(Arena* arena, uint64_t size);
+static void* ArenaVecReallocate(void* context,
+                                void* ptr,
+                                uint64_t old_size,
+                                uint64_t new_size);
+static void ArenaVecRelease(void* context, void* ptr, uint64_t size);
+static uint64_t AlignUp(uint64_t n);
+
+void ArenaInit(Arena* arena, uint64_t chunk_size) {
+  *arena = (Arena){
+      .chunk_size = chunk_size == 0 ? ARENA_DEFAULT_CHUNK_SIZE : chunk_size,
+      .allocator =
+          {
+              .reallocate = ArenaVecReallocate,
+              .release = ArenaVecRelease,
+              .context = arena,
+          },
+  };
+}
+
+void ArenaFree(Arena* arena) {
+  ArenaChunk* chunk = arena->chunk;
+  while (chunk != NULL) {
+    ArenaChunk* prev = chunk->prev;
+    free(chunk);
+    chunk = prev;
+  }
+  arena->chunk = NULL;
+  arena->cursor = NULL;
+  arena->limit = NULL;
+  arena->last = NULL;
+}
+
+void* ArenaAlloc(Arena* arena, uint64_t size) {
+  size = AlignUp(size == 0 ? 1 : size);
+  if ((uint64_t)(arena->limit - arena->cursor) < size &&
+      !ArenaGrow(arena, size)) {
+    return NULL;
+  }
+  arena->last = arena->cursor;
+  arena->cursor += size;
+  return arena->last;
+}
+
+void* ArenaRealloc(Arena* arena,
+                   void* ptr,
+                   uint64_t old_size,
+                   uint64_t new_size) {
+  if (ptr == NULL) {
+    return ArenaAlloc(arena, new_size);
+  }
+  if (ptr == arena->last &&
+      (uint64_t)(arena->limit - arena->last) >= AlignUp(new_size)) {
+    arena->cursor = arena->last + AlignUp(new_size);
+    return ptr;
+  }
+  void* moved = ArenaAlloc(arena, new_size);
+  if (moved != NULL) {
+    memcpy(moved, ptr, old_size < new_size ? old_size : new_size);
+  }
+  return moved;
+}
+
+ArenaMark ArenaGetMark(const Arena* arena) {
+  return (ArenaMark){.chunk = arena->chunk, .cursor = arena->cursor};
+}
+
+void ArenaRelease(Arena* arena, ArenaMark mark) {
+  while (arena->chunk != mark.chunk) {
+    ArenaChunk* prev = arena->chunk->prev;
+    free(arena->chunk);
+    arena->chunk = prev;
+  }
+  arena->cursor = mark.cursor;
+  arena->limit =
+      arena->chunk == NULL ? NULL : arena->chunk->data + arena->chunk->size;
+  arena->last = NULL;
+}
+
+void ArenaReset(Arena* arena) {
+  if (arena->chunk == NULL) {
+    return;
+  }
+  while (arena->chunk->prev != NULL) {
+    ArenaChunk* prev = arena->chunk->prev;
+    free(arena->chunk);
+    arena->chunk = prev;
+  }
+  arena->cursor = arena->chunk->data;
+  arena->limit = arena->chunk->data + arena->chunk->size;
+  arena->last = NULL;
+}
+
+const VecAllocator* ArenaVecAllocator(Arena* arena) {
+  return &arena->allocator;
+}
+
+bool ArenaGrow(Arena* arena, uint64_t size) {
+  uint64_t chunk_size = size > arena->chunk_size ? size : arena->chunk_size;
+  ArenaChunk* chunk = malloc(sizeof(ArenaChunk) + chunk_size);
+  if (chunk == NULL) {
+    return false;
+  }
+  chunk->prev = arena->chunk;
+  chunk->size = chunk_size;
+  arena->chunk = chunk;
+  arena->cursor = chunk->data;
+  arena->limit = chunk->data + chunk_size;
+  return true;
+}
+
+void* ArenaVecReallocate(void* context,
+                         void* ptr,
+                         uint64_t old_size,
+                         uint64_t new_size) {
+  return ArenaRealloc(context, ptr, old_size, new_size);
+}
+
+void ArenaVecRelease(void* context, void* ptr, uint64_t size) {
+  Arena* arena = context;
+  if (ptr == arena->last && arena->last + AlignUp(size) == arena->cursor) {
+    arena->cursor = arena->last;
+    arena->last = NULL;
+  }
+}
+
+uint64_t AlignUp(uint64_t n) {
+  return (n + ARENA_ALIGN - 1) & ~(uint64_t)(ARENA_ALIGN - 1);
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <vec/vec.h>
+
+#include "pas/string.h"
+
+#define PAS_NO_SYMBOL UINT32_MAX
+
+#define PAS_INTERN_HASH_SEED 0xcbf29ce484222325ull
+#define PAS_INTERN_HASH_PRIME 0x100000001b3ull
+
+// Maps identifiers, compared case-insensitively, to dense symbol IDs in
+// order of first appearance. Not thread-safe.
+typedef struct {
+  // Open-addressed table of symbol + 1 in the low half and the high half of
+  // its hash in the high half, or 0 for an empty slot. Its size is zero or a
+  // power of two.
+  VEC_TYPE(uint64_t) slots;
+  VEC_TYPE(uint64_t) hashes;
+  // Symbol i is text [starts[i], starts[i + 1]), spelled as first seen.
+  VEC_TYPE(uint64_t) starts;
+  VEC_TYPE(char) text;
+} PasInterner;
+
+// FNV-1a over identifier bytes with ASCII case folded. Setting bit 5 folds
+// letters and leaves digits and '_' distinct, so the lexer can fold and hash
+// in the loop that scans the identifier.
+static inline uint64_t PasInternHashStep(uint64_t hash, char c) {
+  return (hash ^ (uint8_t)(c | 0x20)) * PAS_INTERN_HASH_PRIME;
+}
+
+uint64_t PasInternHash(const char* text, uint64_t length);
+
+void PasInternerInit(PasInterner* interner, const VecAllocator* allocator);
+void PasInternerFree(PasInterner* interner);
+// Returns the symbol of `text`, whose PasInternHash is `hash`, adding it if
+// needed, or PAS_NO_SYMBOL if out of memory.
+uint32_t PasInternerAdd(PasInterner* interner,
+                        const char* text,
+                        uint64_t length,
+                        uint64_t hash);
+// Returns the symbol of `text`, or PAS_NO_SYMBOL if it was never added.
+uint32_t PasInternerFind(const PasInterner* interner,
+                         const char* text,
+                         uint64_t length,
+                         uint64_t hash);
+StringView PasInternerText(const PasInterner* interner, uint32_t symbol);
+
+static inline uint32_t PasInternerSize(const PasInterner* interner) {
+  return (uint32_t)interner->hashes.size;
+}
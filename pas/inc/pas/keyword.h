@@ -0,0 +1,26 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "pas/token.h"
+
+#define PAS_KEYWORD_HASH_BITS_ 8
+#define PAS_KEYWORD_SLOTS_ (1 << PAS_KEYWORD_HASH_BITS_)
+
+// Packs the length and the case-folded first two and last two characters of
+// a word. Shared with pasgen, which searches for a seed that makes
+// PasKeywordHash collision-free over every keyword.
+static inline uint64_t PasKeywordKey(const char* text, uint64_t length) {
+  return length | (uint64_t)(uint8_t)(text[0] | 0x20) << 8 |
+         (uint64_t)(uint8_t)(text[1] | 0x20) << 16 |
+         (uint64_t)(uint8_t)(text[length - 2] | 0x20) << 24 |
+         (uint64_t)(uint8_t)(text[length - 1] | 0x20) << 32;
+}
+
+static inline uint32_t PasKeywordHash(uint64_t key, uint64_t seed) {
+  return (uint32_t)((key * seed) >> (64 - PAS_KEYWORD_HASH_BITS_));
+}
+
+// Returns the keyword type of `text`, matched case-insensitively, or
+// kPasTokenTypeIdent if it is not a keyword.
+PasTokenType PasKeywordLookup(const char* text, uint64_t length);
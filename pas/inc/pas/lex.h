@@ -1,111 +1,159 @@
 #pragma once
 
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <vec/vec.h>
 
+#include "pas/intern.h"
+#include "pas/scan.h"
+#include "pas/source.h"
 #include "pas/string.h"
+#include "pas/token.h"
 
-#define PAS_TOKEN_TYPE_VARIANTS_ \
-  X(Zero)                        \
-                                 \
-  X(And)                         \
-  X(Array)                       \
-  X(Begin)                       \
-  X(Boolean)                     \
-  X(Case)                        \
-  X(Char)                        \
-  X(Chr)                         \
-  X(Const)                       \
-  X(Div)                         \
-  X(Do)                          \
-  X(Downto)                      \
-  X(Else)                        \
-  X(End)                         \
-  X(File)                        \
-  X(For)                         \
-  X(Function)                    \
-  X(Goto)                        \
-  X(If)                          \
-  X(In)                          \
-  X(Integer)                     \
-  X(Label)                       \
-  X(Mod)                         \
-  X(Nil)                         \
-  X(Not)                         \
-  X(Of)                          \
-  X(Or)                          \
-  X(Packed)                      \
-  X(Procedure)                   \
-  X(Program)                     \
-  X(Real)                        \
-  X(Record)                      \
-  X(Repeat)                      \
-  X(Set)                         \
-  X(Then)                        \
-  X(To)                          \
-  X(Type)                        \
-  X(Until)                       \
-  X(Var)                         \
-  X(While)                       \
-  X(With)                        \
-                                 \
-  X(Plus)                        \
-  X(Minus)                       \
-  X(Star)                        \
-  X(Slash)                       \
-  X(Assign)                      \
-  X(Comma)                       \
-  X(Semi)                        \
-  X(Colon)                       \
-  X(Equal)                       \
-  X(NotEqual)                    \
-  X(Lt)                          \
-  X(Le)                          \
-  X(Ge)                          \
-  X(Gt)                          \
-  X(LParen)                      \
-  X(RParen)                      \
-  X(LBracket)                    \
-  X(LBracket2)                   \
-  X(RBracket)                    \
-  X(RBracket2)                   \
-  X(Pointer)                     \
-  X(At)                          \
-  X(Dot)                         \
-  X(DotDot)                      \
-  X(LCurly)                      \
-  X(RCurly)                      \
-  X(Unit)                        \
-  X(Interface)                   \
-  X(Uses)                        \
-  X(String)                      \
-  X(Implementation)              \
-  X(True)                        \
-  X(False)                       \
-  X(Ws)                          \
-  X(Comment1)                    \
-  X(Comment2)                    \
-  X(Ident)                       \
-  X(StringLiteral)               \
-  X(NumInt)                      \
-  X(NumReal)
+// Tokens record byte positions only; use PasLineTable to turn a position
+// into a line and column.
+typedef struct {
+  uint64_t position;
+  uint64_t length;
+  PasTokenType type;
+  // The interned identifier, or PAS_NO_SYMBOL.
+  uint32_t symbol;
+} PasToken;
+
+// Struct-of-arrays token storage: one byte of type and 32-bit position and
+// length per token. Sources of 4 GiB or more need the 64-bit arrays, which
+// replace the 32-bit ones when `wide` is set.
+typedef struct {
+  VEC_TYPE(uint8_t) types;
+  VEC_TYPE(uint32_t) positions;
+  VEC_TYPE(uint32_t) lengths;
+  VEC_TYPE(uint64_t) positions64;
+  VEC_TYPE(uint64_t) lengths64;
+  bool wide;
+  // When set, `symbols` holds a symbol per token, PAS_NO_SYMBOL for all but
+  // identifiers.
+  PasInterner* interner;
+  VEC_TYPE(uint32_t) symbols;
+  // ENOMEM when lexing stopped early because the stream, its trivia or the
+  // interner could not grow; the tokens before that point are still right.
+  int error;
+} PasTokenStream;
+
+typedef struct {
+  StringView text;
+  uint64_t position;
+  const PasScanKernels* scan;
+  // Interns identifiers as they are scanned when set.
+  PasInterner* interner;
+} PasLexer;
 
 typedef enum {
-#define X(x) kPasTokenType##x,
-  PAS_TOKEN_TYPE_VARIANTS_
-#undef X
-} PasTokenType;
+  // Trivia stays in the token stream.
+  kPasTriviaKeep,
+  kPasTriviaDrop,
+  // Trivia moves to a PasTrivia, indexed by the token that follows it.
+  kPasTriviaAttach,
+} PasTriviaMode;
 
-extern const char* const kPasTokenTypeNames[];
+// The trivia before significant token i is tokens [starts[i], starts[i + 1]),
+// where i runs up to the token count and the last range is the trivia at the
+// end of the source.
+typedef struct {
+  PasTokenStream tokens;
+  VEC_TYPE(uint64_t) starts;
+} PasTrivia;
 
 typedef struct {
-  uint64_t line;
-  uint64_t column;
-  uint64_t position;
-  PasTokenType type;
-  String text;
-} PasToken;
+  // Storage for the token stream; NULL uses realloc/free.
+  const VecAllocator* allocator;
+  // Lex large sources in this many chunks on as many threads; 0 or 1 lexes
+  // sequentially.
+  uint32_t threads;
+  PasTriviaMode trivia;
+  // Receives the trivia in kPasTriviaAttach mode, using `allocator` too.
+  PasTrivia* attached;
+  // Interns identifiers and records their symbols in the stream.
+  PasInterner* interner;
+} PasLexOptions;
+
+// Tokens refer to their text by position and length, so `source` must outlive
+// the returned tokens.
+PasTokenStream PasLex(const PasSource* source);
+PasTokenStream PasLexWithOptions(const PasSource* source,
+                                 const PasLexOptions* options);
+// Lexes `options->threads` chunks concurrently, guessing each chunk's start
+// state, then stitches them. The result is identical to PasLex.
+PasTokenStream PasLexParallel(const PasSource* source,
+                              const PasLexOptions* options);
+
+// Pull interface: PasLexerNext yields one token at a time and returns false
+// once the source is exhausted.
+void PasLexerInit(PasLexer* lexer, const PasSource* source);
+bool PasLexerNext(PasLexer* lexer, PasToken* token);
+void PasLexerFinish(PasLexer* lexer);
+
+StringView PasTokenText(StringView source, const PasToken* token);
+String PasTokenTextCopy(StringView source, const PasToken* token);
+
+// Brings `tokens`, lexed before an edit, up to date with `source`, the text
+// after `removed` bytes at `start` were replaced by `inserted` bytes. Only
+// tokens from the last boundary before the edit up to the point where the
+// new boundaries line up with the old ones are lexed again; later tokens are
+// shifted. `tokens` must hold every token of the old text. New identifiers go
+// to the stream's interner, if any. Returns false, with `tokens` unchanged,
+// if memory runs out.
+bool PasRelex(PasTokenStream* tokens,
+              const PasSource* source,
+              uint64_t start,
+              uint64_t removed,
+              uint64_t inserted);
+
+void PasTriviaFree(PasTrivia* trivia);
+
+void PasTokenStreamInit(PasTokenStream* stream,
+                        bool wide,
+                        const VecAllocator* allocator);
+// Makes room for `count` tokens in total, so that pushes up to that many do
+// not reallocate.
+bool PasTokenStreamReserve(PasTokenStream* stream, uint64_t count);
+// Returns false, with the stream unchanged, if memory runs out.
+bool PasTokenStreamPush(PasTokenStream* stream, const PasToken* token);
+void PasTokenStreamFree(PasTokenStream* stream);
+
+static inline uint64_t PasTokenStreamSize(const PasTokenStream* stream) {
+  return stream->types.size;
+}
+
+static inline PasTokenType PasTokenStreamType(const PasTokenStream* stream,
+                                              uint64_t index) {
+  return (PasTokenType)stream->types.data[index];
+}
+
+static inline uint64_t PasTokenStreamPosition(const PasTokenStream* stream,
+                                              uint64_t index) {
+  return stream->wide ? stream->positions64.data[index]
+                      : stream->positions.data[index];
+}
+
+static inline uint64_t PasTokenStreamLength(const PasTokenStream* stream,
+                                            uint64_t index) {
+  return stream->wide ? stream->lengths64.data[index]
+                      : stream->lengths.data[index];
+}
 
-typedef VEC_TYPE(PasToken) PasTokens;
+static inline uint32_t PasTokenStreamSymbol(const PasTokenStream* stream,
+                                            uint64_t index) {
+  return stream->interner != NULL ? stream->symbols.data[index]
+                                  : PAS_NO_SYMBOL;
+}
 
-PasTokens PasLex(String text);
+static inline PasToken PasTokenStreamGet(const PasTokenStream* stream,
+                                         uint64_t index) {
+  return (PasToken){
+      .position = PasTokenStreamPosition(stream, index),
+      .length = PasTokenStreamLength(stream, index),
+      .type = PasTokenStreamType(stream, index),
+      .symbol = PasTokenStreamSymbol(stream, index),
+  };
+}
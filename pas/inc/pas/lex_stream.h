@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "pas/lex.h"
+#include "pas/string.h"
+#include "pas/token.h"
+
+#define PAS_STREAM_DEFAULT_CHUNK (1 << 20)
+
+// Lexes input read from a file descriptor a chunk at a time, so a pipe of
+// any length can be lexed in memory proportional to the chunk size. The
+// window holds the bytes from the start of the next token; it grows only
+// when a single token is longer than a chunk, since the caller gets each
+// token's text whole. Tokens are the same as PasLex gives for the whole
+// input, with positions counted from its start.
+typedef struct {
+  int fd;
+  char* buffer;
+  // Bytes the window can hold, not counting the NUL padding after them.
+  uint64_t capacity;
+  uint64_t chunk_size;
+  // Input offset of buffer[0], and the bytes in the window.
+  uint64_t base;
+  uint64_t size;
+  bool eof;
+  // The errno of a failed read or allocation, or 0.
+  int error;
+  // Lexes the window; its position is the start of the next token.
+  PasLexer lexer;
+  // A whitespace, identifier, comment or string token that ran into the end
+  // of the window. Once more input is read it is continued from `resume`
+  // rather than lexed again from its start. kPasTokenTypeZero if none.
+  PasTokenType pending;
+  uint64_t resume;
+} PasStreamLexer;
+
+// `chunk_size` 0 means PAS_STREAM_DEFAULT_CHUNK. Returns false and leaves
+// errno set if the window cannot be allocated.
+bool PasStreamLexerInit(PasStreamLexer* lexer, int fd, uint64_t chunk_size);
+// Reads as much input as the next token needs. `text` stays valid until the
+// next call. Returns false at the end of input, or on error with
+// `lexer->error` set.
+bool PasStreamLexerNext(PasStreamLexer* lexer,
+                        PasToken* token,
+                        StringView* text);
+// Does not close `fd`.
+void PasStreamLexerFinish(PasStreamLexer* lexer);
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <vec/vec.h>
+
+#include "pas/string.h"
+
+// Maps byte positions to 1-based lines and columns. Built once per source
+// when something actually needs line numbers.
+typedef struct {
+  VEC_TYPE(uint64_t) starts;
+} PasLineTable;
+
+bool PasLineTableBuild(PasLineTable* table, StringView source);
+void PasLineTableFree(PasLineTable* table);
+void PasLineTableLookup(const PasLineTable* table,
+                        uint64_t position,
+                        uint64_t* line,
+                        uint64_t* column);
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "pas/lex.h"
+#include "pas/string.h"
+
+// Range of the 128-bit powers of five that pasgen generates for
+// PasNumberParseReal. Outside it every 19-digit mantissa rounds to zero or
+// infinity.
+#define PAS_NUMBER_MIN_POW10_ (-342)
+#define PAS_NUMBER_MAX_POW10_ 308
+
+// Decodes the digits of a NumInt token. Returns false if `text` is not all
+// digits or the value does not fit in 64 bits.
+bool PasNumberParseInt(const char* text, uint64_t length, uint64_t* value);
+// Decodes a NumInt or NumReal token to the nearest double; out-of-range
+// values become zero or infinity. Returns false if `text` is not a number.
+bool PasNumberParseReal(const char* text, uint64_t length, double* value);
+
+bool PasTokenInt(StringView source, const PasToken* token, uint64_t* value);
+bool PasTokenReal(StringView source, const PasToken* token, double* value);
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <vec/vec.h>
+
+#include "pas/lex.h"
+#include "pas/string.h"
+#include "pas/token.h"
+
+// Children are listed in order; bracketed ones are optional and recognized
+// by their kind. A statement list may hold a Name or Call as a procedure
+// call statement.
+#define PAS_NODE_KIND_VARIANTS_                                               \
+  X(Program)        /* token: name or none; [Uses], Block */                 \
+  X(Unit)           /* token: name; Interface, Implementation */             \
+  X(Interface)      /* [Uses], sections and routine headings */              \
+  X(Implementation) /* [Uses], sections, routines, [Compound] */             \
+  X(Uses)           /* Name... */                                            \
+  X(Block)          /* sections and routines..., Compound */                 \
+  X(LabelSection)   /* Int or Name... */                                     \
+  X(ConstSection)   /* ConstDecl... */                                       \
+  X(ConstDecl)      /* token: name; [type], value */                         \
+  X(TypeSection)    /* TypeDecl... */                                        \
+  X(TypeDecl)       /* token: name; type */                                  \
+  X(VarSection)     /* VarDecl... */                                         \
+  X(VarDecl)        /* Name..., type */                                      \
+  X(Procedure)      /* token: name; [Params], [Block or Directive] */        \
+  X(Function)       /* token: name; [Params], [type], [Block or Directive] */ \
+  X(Params)         /* ParamGroup... */                                      \
+  X(ParamGroup)     /* op: Var, Const or Zero; Name..., [type] */            \
+  X(Directive)      /* token: forward, external, ... */                      \
+                                                                              \
+  X(TypeName)       /* token: name */                                        \
+  X(StringType)     /* [length] */                                           \
+  X(PointerType)    /* TypeName */                                           \
+  X(ArrayType)      /* op: Packed or Zero; index types..., element type */   \
+  X(RecordType)     /* op: Packed or Zero; VarDecl..., [VariantPart] */      \
+  X(VariantPart)    /* token: tag name or none; tag type, VariantArm... */   \
+  X(VariantArm)     /* labels..., RecordType */                              \
+  X(SetType)        /* op: Packed or Zero; element type */                   \
+  X(FileType)       /* op: Packed or Zero; [element type] */                 \
+  X(EnumType)       /* Name... */                                            \
+  X(SubrangeType)   /* low, high */                                          \
+                                                                              \
+  X(Compound)       /* statements... */                                      \
+  X(Assign)         /* target, value */                                      \
+  X(If)             /* condition, then, [else] */                            \
+  X(While)          /* condition, body */                                    \
+  X(Repeat)         /* statements..., condition */                           \
+  X(For)            /* op: To or Downto; Name, from, to, body */             \
+  X(Case)           /* selector, CaseArm..., [CaseElse] */                   \
+  X(CaseArm)        /* labels..., statement */                               \
+  X(CaseElse)       /* statements... */                                      \
+  X(With)           /* records..., body */                                   \
+  X(Goto)           /* token: label */                                       \
+  X(Labeled)        /* token: label; statement */                            \
+  X(Empty)                                                                    \
+                                                                              \
+  X(Binary)         /* op: operator; left, right */                          \
+  X(Unary)          /* op: operator; operand */                              \
+  X(Name)           /* token: identifier */                                  \
+  X(Int)                                                                      \
+  X(Real)                                                                     \
+  X(String)         /* [String and CharCode pieces...] */                    \
+  X(CharCode)       /* token: '^' of ^C or '#' of #N */                      \
+  X(Nil)                                                                      \
+  X(Bool)           /* token: true or false */                               \
+  X(Set)            /* elements... */                                        \
+  X(Range)          /* low, high */                                          \
+  X(Call)           /* callee, arguments... */                               \
+  X(Index)          /* array, indices... */                                  \
+  X(Field)          /* token: field name; record */                          \
+  X(Deref)          /* pointer */                                            \
+  X(Format)         /* value, width, [precision] */
+
+typedef enum {
+#define X(x) kPasNode##x,
+  PAS_NODE_KIND_VARIANTS_
+#undef X
+} PasNodeKind;
+
+extern const char* const kPasNodeKindNames[];
+
+#define PAS_NO_TOKEN UINT32_MAX
+
+// `token` indexes the token stream the tree was parsed from and `children`
+// indexes PasAst::children.
+typedef struct {
+  uint8_t kind;
+  uint8_t op;
+  uint32_t token;
+  uint32_t children;
+  uint32_t child_count;
+} PasNode;
+
+// The whole tree lives in two arrays, so freeing it, or releasing the arena
+// it was allocated from, frees every node at once.
+typedef struct {
+  VEC_TYPE(PasNode) nodes;
+  VEC_TYPE(uint32_t) children;
+  uint32_t root;
+} PasAst;
+
+typedef struct {
+  uint64_t position;
+  const char* message;
+  // The token that was required, or kPasTokenTypeZero.
+  PasTokenType expected;
+} PasParseError;
+
+// Parses a program or unit. Trivia in `tokens` is skipped, so any trivia
+// mode works. On failure `error` describes the first problem and `ast` is
+// left empty.
+bool PasParse(const PasTokenStream* tokens,
+              StringView text,
+              const VecAllocator* allocator,
+              PasAst* ast,
+              PasParseError* error);
+void PasAstFree(PasAst* ast);
+
+static inline const uint32_t* PasAstChildren(const PasAst* ast,
+                                             const PasNode* node) {
+  return ast->children.data + node->children;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdint.h>
+
+// Run-finding kernels used by the lexer. Each returns the first byte at or
+// after `begin` that ends the run. Every run also ends at NUL, so the input
+// must be NUL-padded as PasSource guarantees; callers tell an embedded NUL
+// from the end of input by position.
+
+typedef const char* (*PasScanKernel)(const char* begin);
+// Counts the newlines in [begin, end); needs no padding.
+typedef uint64_t (*PasCountKernel)(const char* begin, const char* end);
+
+typedef struct {
+  const char* name;
+  PasScanKernel whitespace;
+  PasScanKernel identifier;
+  // Stops at '}' or NUL.
+  PasScanKernel brace_comment;
+  // Stops at '*' or NUL; the caller checks for the ')' after it.
+  PasScanKernel paren_comment;
+  // Stops at '\'' or NUL.
+  PasScanKernel quote;
+  PasCountKernel newlines;
+} PasScanKernels;
+
+typedef enum {
+  kPasScanLevelScalar,
+  kPasScanLevelSse2,
+  kPasScanLevelAvx2,
+} PasScanLevel;
+
+// Returns NULL if `level` is not supported by this build or CPU.
+const PasScanKernels* PasScanKernelsFor(PasScanLevel level);
+// Returns the best kernels supported by the running CPU.
+const PasScanKernels* PasScanKernelsBest(void);
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "pas/string.h"
+
+// Every PasSource is followed by at least this many NUL bytes, so the lexer
+// can peek and load vectors past the end without bounds checks.
+#define PAS_SOURCE_PADDING 64
+
+typedef struct {
+  const char* data;
+  uint64_t size;
+  void* mapping;
+  uint64_t mapping_size;
+} PasSource;
+
+// Maps `path` read-only, falling back to reading it into memory when it
+// cannot be mapped (pipes, character devices). "-" names standard input.
+// Returns false and leaves errno set on failure.
+bool PasSourceOpen(PasSource* source, const char* path);
+bool PasSourceReadFd(PasSource* source, int fd);
+// Copies `size` bytes of `data` into a padded buffer.
+bool PasSourceFromMemory(PasSource* source, const char* data, uint64_t size);
+void PasSourceClose(PasSource* source);
+
+StringView PasSourceView(const PasSource* source);
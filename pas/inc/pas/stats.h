@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "pas/token.h"
+
+// The lexer branch that produced a token, derived from its type.
+#define PAS_LEX_BRANCH_VARIANTS_ \
+  X(Identifier)                  \
+  X(Number)                      \
+  X(Whitespace)                  \
+  X(Comment)                     \
+  X(String)                      \
+  X(Punctuation)
+
+typedef enum {
+#define X(x) kPasLexBranch##x,
+  PAS_LEX_BRANCH_VARIANTS_
+#undef X
+} PasLexBranch;
+
+enum {
+#define X(x) +1
+  kPasLexBranchCount = 0 PAS_LEX_BRANCH_VARIANTS_
+#undef X
+};
+
+extern const char* const kPasLexBranchNames[];
+
+// Collected only when the library is built with PAS_STATS; otherwise the
+// hooks compile to nothing and PasLexStatsGet fails. Ticks come from the
+// cycle counter where there is one and are nanoseconds elsewhere; they include
+// time spent on tokens that the streaming and parallel lexers lex again or
+// throw away, while the token counts do not.
+typedef struct {
+  uint64_t tokens[kPasTokenTypeCount];
+  uint64_t bytes[kPasTokenTypeCount];
+  uint64_t branch_tokens[kPasLexBranchCount];
+  uint64_t branch_ticks[kPasLexBranchCount];
+  uint64_t keyword_hits;
+  uint64_t keyword_misses;
+  // Blocks obtained and bytes added by growing the vecs of the library: token
+  // streams and trivia, interners and line tables.
+  uint64_t allocations;
+  uint64_t allocation_bytes;
+} PasLexStats;
+
+// Totals over every lexer finished so far, on any thread.
+bool PasLexStatsGet(PasLexStats* stats);
+void PasLexStatsReset(void);
+PasLexBranch PasLexBranchOf(PasTokenType type);
@@ -1,10 +1,21 @@
 #pragma once
 
+#include <stdint.h>
 #include <vec/vec.h>
 
 typedef VEC_TYPE(char) String;
 
+typedef struct {
+  const char* data;
+  uint64_t size;
+} StringView;
+
 String StringMake(const char* left, const char* right);
 String StringMakeC(const char* c);
 String StringDuplicate(const String* s);
 void StringDowncase(String* s);
+
+StringView StringViewMake(const char* data, uint64_t size);
+StringView StringViewOf(const String* s);
+String StringFromView(StringView v);
+String StringFromViewWith(StringView v, const VecAllocator* allocator);
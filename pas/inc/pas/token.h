@@ -0,0 +1,143 @@
+#pragma once
+
+#include <stdbool.h>
+
+#define PAS_TOKEN_KEYWORD_VARIANTS_ \
+  X(And)                            \
+  X(Array)                          \
+  X(Begin)                          \
+  X(Boolean)                        \
+  X(Case)                           \
+  X(Char)                           \
+  X(Chr)                            \
+  X(Const)                          \
+  X(Div)                            \
+  X(Do)                             \
+  X(Downto)                         \
+  X(Else)                           \
+  X(End)                            \
+  X(File)                           \
+  X(For)                            \
+  X(Function)                       \
+  X(Goto)                           \
+  X(If)                             \
+  X(In)                             \
+  X(Integer)                        \
+  X(Label)                          \
+  X(Mod)                            \
+  X(Nil)                            \
+  X(Not)                            \
+  X(Of)                             \
+  X(Or)                             \
+  X(Packed)                         \
+  X(Procedure)                      \
+  X(Program)                        \
+  X(Real)                           \
+  X(Record)                         \
+  X(Repeat)                         \
+  X(Set)                            \
+  X(Then)                           \
+  X(To)                             \
+  X(Type)                           \
+  X(Until)                          \
+  X(Var)                            \
+  X(While)                          \
+  X(With)                           \
+  X(Unit)                           \
+  X(Interface)                      \
+  X(Uses)                           \
+  X(String)                         \
+  X(Implementation)                 \
+  X(True)                           \
+  X(False)
+
+#define PAS_TOKEN_TYPE_VARIANTS_ \
+  X(Zero)                        \
+                                 \
+  PAS_TOKEN_KEYWORD_VARIANTS_    \
+                                 \
+  X(Plus)                        \
+  X(Minus)                       \
+  X(Star)                        \
+  X(Slash)                       \
+  X(Assign)                      \
+  X(Comma)                       \
+  X(Semi)                        \
+  X(Colon)                       \
+  X(Equal)                       \
+  X(NotEqual)                    \
+  X(Lt)                          \
+  X(Le)                          \
+  X(Ge)                          \
+  X(Gt)                          \
+  X(LParen)                      \
+  X(RParen)                      \
+  X(LBracket)                    \
+  X(LBracket2)                   \
+  X(RBracket)                    \
+  X(RBracket2)                   \
+  X(Pointer)                     \
+  X(At)                          \
+  X(Dot)                         \
+  X(DotDot)                      \
+  X(LCurly)                      \
+  X(RCurly)                      \
+                                 \
+  X(Ws)                          \
+  X(Comment1)                    \
+  X(Comment2)                    \
+  X(Ident)                       \
+  X(StringLiteral)               \
+  X(NumInt)                      \
+  X(NumReal)
+
+// The tokens with a fixed spelling of one or two bytes. pasgen builds the
+// lexer's operator tables from this list, so a new operator needs only an
+// entry here. Comment2 is listed by its opener; the lexer scans to the end.
+#define PAS_TOKEN_SPELLING_VARIANTS_ \
+  X(Plus, "+")                       \
+  X(Minus, "-")                      \
+  X(Star, "*")                       \
+  X(Slash, "/")                      \
+  X(Assign, ":=")                    \
+  X(Comma, ",")                      \
+  X(Semi, ";")                       \
+  X(Colon, ":")                      \
+  X(Equal, "=")                      \
+  X(NotEqual, "<>")                  \
+  X(Lt, "<")                         \
+  X(Le, "<=")                        \
+  X(Ge, ">=")                        \
+  X(Gt, ">")                         \
+  X(LParen, "(")                     \
+  X(RParen, ")")                     \
+  X(LBracket, "[")                   \
+  X(LBracket2, "(.")                 \
+  X(RBracket, "]")                   \
+  X(RBracket2, ".)")                 \
+  X(Pointer, "^")                    \
+  X(At, "@")                         \
+  X(Dot, ".")                        \
+  X(DotDot, "..")                    \
+  X(RCurly, "}")                     \
+  X(Comment2, "(*")
+
+typedef enum {
+#define X(x) kPasTokenType##x,
+  PAS_TOKEN_TYPE_VARIANTS_
+#undef X
+} PasTokenType;
+
+enum {
+#define X(x) +1
+  kPasTokenTypeCount = 0 PAS_TOKEN_TYPE_VARIANTS_
+#undef X
+};
+
+extern const char* const kPasTokenTypeNames[];
+
+// Whitespace and comments carry no meaning for a parser.
+static inline bool PasTokenTypeIsTrivia(PasTokenType type) {
+  return type == kPasTokenTypeWs || type == kPasTokenTypeComment1 ||
+         type == kPasTokenTypeComment2;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "pas/lex.h"
+#include "pas/string.h"
+
+// "PASTOKS" plus a NUL, read as a little-endian word, so a file written on a
+// machine of the other byte order fails the magic check.
+#define PAS_TOKEN_FILE_MAGIC 0x00534b4f54534150ull
+#define PAS_TOKEN_FILE_VERSION 1
+
+enum {
+  kPasTokenFileWide = 1 << 0,
+};
+
+// A token file is this header followed by the type, position and length
+// arrays of a PasTokenStream, each starting at an 8-byte aligned offset, in
+// native byte order. Positions and lengths are 64-bit when the wide flag is
+// set.
+typedef struct {
+  uint64_t magic;
+  uint32_t version;
+  uint32_t flags;
+  uint64_t count;
+  uint64_t source_size;
+  uint64_t source_hash;
+  // Byte offsets from the start of the file.
+  uint64_t types;
+  uint64_t positions;
+  uint64_t lengths;
+} PasTokenFileHeader;
+
+typedef struct {
+  void* mapping;
+  uint64_t size;
+  // Refers to the mapping. It is read-only: pushing to it fails and freeing
+  // it does nothing.
+  PasTokenStream tokens;
+} PasTokenFile;
+
+// XXH64 with seed 0, used to tie a token file to its source.
+uint64_t PasTokenFileHash(StringView source);
+
+// Writes the types, positions and lengths of `tokens`, lexed from `source`,
+// to `path`, replacing it only once the whole file is written. Symbols are
+// not saved, as they belong to an interner. Returns false and leaves errno set
+// on failure.
+bool PasTokenFileWrite(const char* path,
+                       const PasTokenStream* tokens,
+                       StringView source);
+// Maps `path` and checks it against `source`. Returns false with errno set to
+// EINVAL for a malformed file, including one with a token of unknown type or
+// past the end of the source, and ESTALE when it was written for another
+// source; the caller should lex again in either case.
+bool PasTokenFileOpen(PasTokenFile* file, const char* path, StringView source);
+void PasTokenFileClose(PasTokenFile* file);
@@ -0,0 +1,145 @@
+#include "pas/intern.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "lex_stats.h"
+
+#define INTERN_MIN_SLOTS 256
+
+#define INTERN_ENTRY(Symbol, Hash) \
+  (((Hash) & 0xffffffff00000000ull) | ((uint64_t)(Symbol) + 1))
+#define INTERN_SYMBOL(Entry) ((uint32_t)(Entry) - 1)
+
+static uint64_t InternProbe(const PasInterner* interner,
+                            const char* text,
+                            uint64_t length,
+                            uint64_t hash);
+static bool InternSame(const char* a, const char* b, uint64_t length);
+static bool InternGrow(PasInterner* interner);
+
+uint64_t PasInternHash(const char* text, uint64_t length) {
+  uint64_t hash = PAS_INTERN_HASH_SEED;
+  for (uint64_t i = 0; i < length; ++i) {
+    hash = PasInternHashStep(hash, text[i]);
+  }
+  return hash;
+}
+
+void PasInternerInit(PasInterner* interner, const VecAllocator* allocator) {
+  *interner = (PasInterner){0};
+  allocator = LEX_STATS_ALLOCATOR(allocator);
+  VEC_SET_ALLOCATOR(&interner->slots, allocator);
+  VEC_SET_ALLOCATOR(&interner->hashes, allocator);
+  VEC_SET_ALLOCATOR(&interner->starts, allocator);
+  VEC_SET_ALLOCATOR(&interner->text, allocator);
+}
+
+void PasInternerFree(PasInterner* interner) {
+  VEC_FREE(&interner->slots);
+  VEC_FREE(&interner->hashes);
+  VEC_FREE(&interner->starts);
+  VEC_FREE(&interner->text);
+}
+
+uint32_t PasInternerAdd(PasInterner* interner,
+                        const char* text,
+                        uint64_t length,
+                        uint64_t hash) {
+  // Keep the table at most half full.
+  if ((interner->hashes.size + 1) * 2 > interner->slots.size &&
+      !InternGrow(interner)) {
+    return PAS_NO_SYMBOL;
+  }
+  uint64_t slot = InternProbe(interner, text, length, hash);
+  if (interner->slots.data[slot] != 0) {
+    return INTERN_SYMBOL(interner->slots.data[slot]);
+  }
+  uint64_t symbol = interner->hashes.size;
+  if (symbol >= PAS_NO_SYMBOL - 1 ||
+      (interner->starts.size == 0 && !VEC_PUSH(&interner->starts, 0)) ||
+      !VEC_APPEND(&interner->text, text, length) ||
+      !VEC_PUSH(&interner->starts, interner->text.size) ||
+      !VEC_PUSH(&interner->hashes, hash)) {
+    // Drop whatever was added so the tables stay consistent.
+    if (interner->starts.size > symbol) {
+      interner->starts.size = symbol + 1;
+      interner->text.size = interner->starts.data[symbol];
+    }
+    return PAS_NO_SYMBOL;
+  }
+  interner->slots.data[slot] = INTERN_ENTRY(symbol, hash);
+  return (uint32_t)symbol;
+}
+
+uint32_t PasInternerFind(const PasInterner* interner,
+                         const char* text,
+                         uint64_t length,
+                         uint64_t hash) {
+  if (interner->slots.size == 0) {
+    return PAS_NO_SYMBOL;
+  }
+  uint64_t entry =
+      interner->slots.data[InternProbe(interner, text, length, hash)];
+  return entry == 0 ? PAS_NO_SYMBOL : INTERN_SYMBOL(entry);
+}
+
+StringView PasInternerText(const PasInterner* interner, uint32_t symbol) {
+  uint64_t start = interner->starts.data[symbol];
+  return StringViewMake(interner->text.data + start,
+                        interner->starts.data[symbol + 1] - start);
+}
+
+// Returns the slot holding `text` or the empty slot where it belongs.
+uint64_t InternProbe(const PasInterner* interner,
+                     const char* text,
+                     uint64_t length,
+                     uint64_t hash) {
+  uint64_t mask = interner->slots.size - 1;
+  for (uint64_t slot = hash & mask;; slot = (slot + 1) & mask) {
+    uint64_t entry = interner->slots.data[slot];
+    if (entry == 0) {
+      return slot;
+    }
+    // The stored half of the hash rules out most mismatches without touching
+    // the symbol's text.
+    uint32_t symbol = INTERN_SYMBOL(entry);
+    if (((entry ^ hash) >> 32) == 0 &&
+        interner->starts.data[symbol + 1] - interner->starts.data[symbol] ==
+            length &&
+        InternSame(interner->text.data + interner->starts.data[symbol], text,
+                   length)) {
+      return slot;
+    }
+  }
+}
+
+bool InternSame(const char* a, const char* b, uint64_t length) {
+  for (uint64_t i = 0; i < length; ++i) {
+    if ((a[i] | 0x20) != (b[i] | 0x20)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool InternGrow(PasInterner* interner) {
+  uint64_t size =
+      interner->slots.size == 0 ? INTERN_MIN_SLOTS : interner->slots.size * 2;
+  if (!VEC_RESERVE(&interner->slots, size)) {
+    return false;
+  }
+  interner->slots.size = size;
+  memset(interner->slots.data, 0, size * sizeof(uint64_t));
+  uint64_t mask = size - 1;
+  for (uint64_t symbol = 0; symbol < interner->hashes.size; ++symbol) {
+    uint64_t hash = interner->hashes.data[symbol];
+    uint64_t slot = hash & mask;
+    while (interner->slots.data[slot] != 0) {
+      slot = (slot + 1) & mask;
+    }
+    interner->slots.data[slot] = INTERN_ENTRY(symbol, hash);
+  }
+  return true;
+}
@@ -0,0 +1,28 @@
+#include "pas/keyword.h"
+
+#include <stdint.h>
+
+typedef struct {
+  char text[16];
+  uint8_t length;
+  PasTokenType type;
+} KeywordSlot;
+
+#include "keywords.inc"
+
+PasTokenType PasKeywordLookup(const char* text, uint64_t length) {
+  if (length < KEYWORD_MIN_LENGTH || length > KEYWORD_MAX_LENGTH) {
+    return kPasTokenTypeIdent;
+  }
+  const KeywordSlot* slot =
+      &kKeywordSlots[PasKeywordHash(PasKeywordKey(text, length), KEYWORD_SEED)];
+  if (slot->length != length) {
+    return kPasTokenTypeIdent;
+  }
+  for (uint64_t i = 0; i < length; ++i) {
+    if ((char)(text[i] | 0x20) != slot->text[i]) {
+      return kPasTokenTypeIdent;
+    }
+  }
+  return slot->type;
+}
@@ -1,395 +1,419 @@
 #include "pas/lex.h"
 
+#include <errno.h>
 #include <stdbool.h>
 #include <stdint.h>
-#include <uthash.h>
+#include <stdlib.h>
 
+#include "lex_run.h"
+#include "lex_sink.h"
+#include "lex_stats.h"
+#include "pas/keyword.h"
+#include "pas/scan.h"
 #include "pas/string.h"
 
+#include "lexer.inc"
+
 const char* const kPasTokenTypeNames[] = {
 #define X(x) #x,
     PAS_TOKEN_TYPE_VARIANTS_
 #undef X
 };
 
-typedef struct {
-  String text;
-  uint64_t line;
-  uint64_t column;
-  uint64_t position;
-} Lexer;
-
-typedef struct {
-  String text;
-  PasTokenType type;
-  UT_hash_handle hh;
-} LexerKeyword;
-
-#define LEXER_LOOK(L, Offset)                 \
-  ((L)->position + (Offset) >= (L)->text.size \
-       ? '\0'                                 \
-       : (L)->text.data[(L)->position + (Offset)])
+// The source is NUL-padded, so peeks need no bounds check; a NUL is the end of
+// input only if it is at or past text.size.
+#define LEXER_LOOK(L, Offset) ((L)->text.data[(L)->position + (Offset)])
 #define LEXER_CUR(L) LEXER_LOOK(L, 0)
 #define LEXER_PEEK(L) LEXER_LOOK(L, 1)
-#define LEXER_NEXT(L)           \
-  do {                          \
-    if (LEXER_CUR(L) == '\n') { \
-      (L)->line++;              \
-      (L)->column = 1;          \
-    } else {                    \
-      (L)->column++;            \
-    }                           \
-    (L)->position++;            \
-  } while (0)
-
-static String LexerText(Lexer* lexer, PasToken* token);
-static void LexExponent(Lexer* lexer);
-static void AddKeyword(LexerKeyword** keywords, String text, PasTokenType type);
-static void CleanupKeywords(LexerKeyword* keywords);
-
-static bool IsIdentifierStart(char c);
+#define LEXER_NEXT(L) ((L)->position++)
+#define LEXER_AT(L, Position) ((L)->text.data + (Position))
+
+// `paspar_bench --verify` checks the vector kernels against the scalar ones.
+#define LEXER_SCAN(L, Kernel, Begin) ((L)->scan->Kernel(Begin) - (L)->text.data)
+
+// Typical source has a token, counting whitespace, every four bytes or so,
+// and a significant one every six. PasLex reserves that much up front so that
+// the common case never reallocates the token arrays.
+#define LEX_BYTES_PER_TOKEN 4
+#define LEX_BYTES_PER_SIGNIFICANT_TOKEN 6
+
+static void LexInternedIdentifier(PasLexer* lexer, PasToken* token);
+static void LexOperator(PasLexer* lexer, PasToken* token);
+static bool LexExponent(PasLexer* lexer);
+
+static bool IsIdentifierPart(char c);
 static bool IsDigit(char c);
 static bool IsSign(char c);
-static bool IsWhiteSpace(char c);
-static bool IsIdentifierPart(char c);
 
-PasTokens PasLex(String text) {
-  Lexer lexer = {
-      .text = text,
-      .line = 1,
-      .column = 1,
+PasTokenStream PasLex(const PasSource* source) {
+  return PasLexWithOptions(source, &(PasLexOptions){0});
+}
+
+PasTokenStream PasLexWithOptions(const PasSource* source,
+                                 const PasLexOptions* options) {
+  if (options->threads > 1) {
+    return PasLexParallel(source, options);
+  }
+  PasLexer lexer;
+  PasLexerInit(&lexer, source);
+  lexer.interner = options->interner;
+  PasTokenStream tokens;
+  PasLexSink sink;
+  PasLexSinkInit(&sink, &tokens, source, options);
+  PasToken token;
+  while (PasLexerNext(&lexer, &token)) {
+    if (!PasLexSinkPush(&sink, &token)) {
+      break;
+    }
+  }
+  PasLexSinkFinish(&sink);
+  PasLexerFinish(&lexer);
+  return tokens;
+}
+
+void PasLexerInit(PasLexer* lexer, const PasSource* source) {
+  *lexer = (PasLexer){
+      .text = PasSourceView(source),
       .position = 0,
+      .scan = PasScanKernelsBest(),
   };
-  LexerKeyword* keywords = NULL;
-  AddKeyword(&keywords, StringMakeC("and"), kPasTokenTypeAnd);
-  AddKeyword(&keywords, StringMakeC("array"), kPasTokenTypeArray);
-  AddKeyword(&keywords, StringMakeC("begin"), kPasTokenTypeBegin);
-  AddKeyword(&keywords, StringMakeC("boolean"), kPasTokenTypeBoolean);
-  AddKeyword(&keywords, StringMakeC("case"), kPasTokenTypeCase);
-  AddKeyword(&keywords, StringMakeC("char"), kPasTokenTypeChar);
-  AddKeyword(&keywords, StringMakeC("chr"), kPasTokenTypeChr);
-  AddKeyword(&keywords, StringMakeC("const"), kPasTokenTypeConst);
-  AddKeyword(&keywords, StringMakeC("div"), kPasTokenTypeDiv);
-  AddKeyword(&keywords, StringMakeC("do"), kPasTokenTypeDo);
-  AddKeyword(&keywords, StringMakeC("downto"), kPasTokenTypeDownto);
-  AddKeyword(&keywords, StringMakeC("else"), kPasTokenTypeElse);
-  AddKeyword(&keywords, StringMakeC("end"), kPasTokenTypeEnd);
-  AddKeyword(&keywords, StringMakeC("file"), kPasTokenTypeFile);
-  AddKeyword(&keywords, StringMakeC("for"), kPasTokenTypeFor);
-  AddKeyword(&keywords, StringMakeC("function"), kPasTokenTypeFunction);
-  AddKeyword(&keywords, StringMakeC("goto"), kPasTokenTypeGoto);
-  AddKeyword(&keywords, StringMakeC("if"), kPasTokenTypeIf);
-  AddKeyword(&keywords, StringMakeC("in"), kPasTokenTypeIn);
-  AddKeyword(&keywords, StringMakeC("integer"), kPasTokenTypeInteger);
-  AddKeyword(&keywords, StringMakeC("label"), kPasTokenTypeLabel);
-  AddKeyword(&keywords, StringMakeC("mod"), kPasTokenTypeMod);
-  AddKeyword(&keywords, StringMakeC("nil"), kPasTokenTypeNil);
-  AddKeyword(&keywords, StringMakeC("not"), kPasTokenTypeNot);
-  AddKeyword(&keywords, StringMakeC("of"), kPasTokenTypeOf);
-  AddKeyword(&keywords, StringMakeC("or"), kPasTokenTypeOr);
-  AddKeyword(&keywords, StringMakeC("packed"), kPasTokenTypePacked);
-  AddKeyword(&keywords, StringMakeC("procedure"), kPasTokenTypeProcedure);
-  AddKeyword(&keywords, StringMakeC("program"), kPasTokenTypeProgram);
-  AddKeyword(&keywords, StringMakeC("real"), kPasTokenTypeReal);
-  AddKeyword(&keywords, StringMakeC("record"), kPasTokenTypeRecord);
-  AddKeyword(&keywords, StringMakeC("repeat"), kPasTokenTypeRepeat);
-  AddKeyword(&keywords, StringMakeC("set"), kPasTokenTypeSet);
-  AddKeyword(&keywords, StringMakeC("then"), kPasTokenTypeThen);
-  AddKeyword(&keywords, StringMakeC("to"), kPasTokenTypeTo);
-  AddKeyword(&keywords, StringMakeC("type"), kPasTokenTypeType);
-  AddKeyword(&keywords, StringMakeC("until"), kPasTokenTypeUntil);
-  AddKeyword(&keywords, StringMakeC("var"), kPasTokenTypeVar);
-  AddKeyword(&keywords, StringMakeC("while"), kPasTokenTypeWhile);
-  AddKeyword(&keywords, StringMakeC("with"), kPasTokenTypeWith);
-  AddKeyword(&keywords, StringMakeC("unit"), kPasTokenTypeUnit);
-  AddKeyword(&keywords, StringMakeC("interface"), kPasTokenTypeInterface);
-  AddKeyword(&keywords, StringMakeC("uses"), kPasTokenTypeUses);
-  AddKeyword(&keywords, StringMakeC("string"), kPasTokenTypeString);
-  AddKeyword(&keywords, StringMakeC("implementation"),
-             kPasTokenTypeImplementation);
-  AddKeyword(&keywords, StringMakeC("true"), kPasTokenTypeTrue);
-  AddKeyword(&keywords, StringMakeC("false"), kPasTokenTypeFalse);
-  PasTokens tokens = {0};
-  while (lexer.position < lexer.text.size) {
-    PasToken token = {
-        .line = lexer.line,
-        .column = lexer.column,
-        .position = lexer.position,
-    };
-    if (IsIdentifierStart(LEXER_CUR(&lexer))) {
-      while (IsIdentifierPart(LEXER_CUR(&lexer))) {
-        LEXER_NEXT(&lexer);
-      }
-      token.type = kPasTokenTypeIdent;
-      token.text = LexerText(&lexer, &token);
-      String lookup_text = StringDuplicate(&token.text);
-      StringDowncase(&lookup_text);
-      VEC_PUSH(&lookup_text, '\0');
-      LexerKeyword* kw;
-      HASH_FIND_STR(keywords, lookup_text.data, kw);
-      VEC_FREE(&lookup_text);
-      if (kw != NULL) {
-        token.type = kw->type;
+}
+
+bool PasLexerNext(PasLexer* lexer, PasToken* token) {
+  if (!PasLexStep(lexer, token)) {
+    return false;
+  }
+  LEX_STATS_TOKEN(token);
+  return true;
+}
+
+bool PasLexStep(PasLexer* lexer, PasToken* token) {
+  if (lexer->position >= lexer->text.size) {
+    return false;
+  }
+  LEX_STATS_START(stats_start);
+  *token = (PasToken){
+      .position = lexer->position,
+      .symbol = PAS_NO_SYMBOL,
+  };
+  switch ((LexClass)kLexClass[(uint8_t)LEXER_CUR(lexer)]) {
+    case kLexClassIdentifier:
+      if (lexer->interner != NULL) {
+        LexInternedIdentifier(lexer, token);
+        break;
       }
-    } else if (IsDigit(LEXER_CUR(&lexer))) {
-      while (IsDigit(LEXER_CUR(&lexer))) {
-        LEXER_NEXT(&lexer);
+      lexer->position =
+          LEXER_SCAN(lexer, identifier, LEXER_AT(lexer, lexer->position + 1));
+      token->type = PasKeywordLookup(lexer->text.data + token->position,
+                                    lexer->position - token->position);
+      break;
+    case kLexClassDigit:
+      while (IsDigit(LEXER_CUR(lexer))) {
+        LEXER_NEXT(lexer);
       }
-      if (LEXER_CUR(&lexer) == '.') {
-        LEXER_NEXT(&lexer);
-        while (IsDigit(LEXER_CUR(&lexer))) {
-          LEXER_NEXT(&lexer);
+      token->type = kPasTokenTypeNumInt;
+      // A '.' not followed by a digit belongs to the next token, as in 1..10.
+      if (LEXER_CUR(lexer) == '.' && IsDigit(LEXER_PEEK(lexer))) {
+        LEXER_NEXT(lexer);
+        while (IsDigit(LEXER_CUR(lexer))) {
+          LEXER_NEXT(lexer);
         }
-        LexExponent(&lexer);
-        token.type = kPasTokenTypeNumReal;
-      } else if (LEXER_CUR(&lexer) == 'e') {
-        LexExponent(&lexer);
-        token.type = kPasTokenTypeNumReal;
-      } else {
-        token.type = kPasTokenTypeNumInt;
+        token->type = kPasTokenTypeNumReal;
       }
-      token.text = LexerText(&lexer, &token);
-    } else if (IsWhiteSpace(LEXER_CUR(&lexer))) {
-      while (IsWhiteSpace(LEXER_CUR(&lexer))) {
-        LEXER_NEXT(&lexer);
+      if (LexExponent(lexer)) {
+        token->type = kPasTokenTypeNumReal;
       }
-      token.type = kPasTokenTypeWs;
-      token.text = LexerText(&lexer, &token);
+      break;
+    case kLexClassSpace:
+      lexer->position =
+          LEXER_SCAN(lexer, whitespace, LEXER_AT(lexer, lexer->position + 1));
+      token->type = kPasTokenTypeWs;
+      break;
+    case kLexClassQuote:
+      lexer->position = PasLexQuoteEnd(lexer, lexer->position + 1);
+      token->type = kPasTokenTypeStringLiteral;
+      break;
+    case kLexClassBrace:
+      // An unterminated comment runs to the end of input, as (* does.
+      lexer->position = PasLexBraceCommentEnd(lexer, lexer->position + 1);
+      token->type = kPasTokenTypeComment1;
+      break;
+    case kLexClassOperator:
+      LexOperator(lexer, token);
+      break;
+    case kLexClassOther:
+      LEXER_NEXT(lexer);
+      break;
+  }
+  if (lexer->position > lexer->text.size) {
+    lexer->position = lexer->text.size;
+  }
+  token->length = lexer->position - token->position;
+  LEX_STATS_TIME(token, stats_start);
+  return true;
+}
+
+void PasLexerFinish(PasLexer* lexer) {
+  LEX_STATS_FLUSH();
+  *lexer = (PasLexer){0};
+}
+
+StringView PasTokenText(StringView source, const PasToken* token) {
+  return StringViewMake(source.data + token->position, token->length);
+}
+
+String PasTokenTextCopy(StringView source, const PasToken* token) {
+  return StringFromView(PasTokenText(source, token));
+}
+
+void PasTokenStreamInit(PasTokenStream* stream,
+                        bool wide,
+                        const VecAllocator* allocator) {
+  *stream = (PasTokenStream){.wide = wide};
+  allocator = LEX_STATS_ALLOCATOR(allocator);
+  VEC_SET_ALLOCATOR(&stream->types, allocator);
+  VEC_SET_ALLOCATOR(&stream->positions, allocator);
+  VEC_SET_ALLOCATOR(&stream->lengths, allocator);
+  VEC_SET_ALLOCATOR(&stream->positions64, allocator);
+  VEC_SET_ALLOCATOR(&stream->lengths64, allocator);
+  VEC_SET_ALLOCATOR(&stream->symbols, allocator);
+}
+
+bool PasTokenStreamReserve(PasTokenStream* stream, uint64_t count) {
+  if (!VEC_RESERVE(&stream->types, count) ||
+      (stream->interner != NULL && !VEC_RESERVE(&stream->symbols, count))) {
+    return false;
+  }
+  if (stream->wide) {
+    return VEC_RESERVE(&stream->positions64, count) &&
+           VEC_RESERVE(&stream->lengths64, count);
+  }
+  return VEC_RESERVE(&stream->positions, count) &&
+         VEC_RESERVE(&stream->lengths, count);
+}
+
+// A failed push takes back the elements already pushed, so the arrays keep
+// the same length.
+bool PasTokenStreamPush(PasTokenStream* stream, const PasToken* token) {
+  uint64_t size = stream->types.size;
+  bool pushed =
+      VEC_PUSH(&stream->types, (uint8_t)token->type) &&
+      (stream->interner == NULL ||
+       VEC_PUSH(&stream->symbols, token->symbol)) &&
+      (stream->wide
+           ? VEC_PUSH(&stream->positions64, token->position) &&
+                 VEC_PUSH(&stream->lengths64, token->length)
+           : VEC_PUSH(&stream->positions, (uint32_t)token->position) &&
+                 VEC_PUSH(&stream->lengths, (uint32_t)token->length));
+  if (!pushed) {
+    stream->types.size = size;
+    if (stream->interner != NULL) {
+      stream->symbols.size = size;
+    }
+    if (stream->wide) {
+      stream->positions64.size = size;
+      stream->lengths64.size = size;
     } else {
-      switch (LEXER_CUR(&lexer)) {
-        case '{': {
-          bool found = false;
-          for (uint64_t i = 0;
-               LEXER_LOOK(&lexer, i) != '\n' && LEXER_LOOK(&lexer, i) != '\0';
-               ++i) {
-            if (LEXER_LOOK(&lexer, i) == '}') {
-              for (uint64_t j = 0; j <= i; ++j) {
-                LEXER_NEXT(&lexer);
-              }
-              found = true;
-              break;
-            }
-          }
-          if (found) {
-            token.type = kPasTokenTypeComment1;
-          } else {
-            LEXER_NEXT(&lexer);
-            token.type = kPasTokenTypeLCurly;
-          }
-          token.text = LexerText(&lexer, &token);
-        } break;
-        case '}':
-          token.type = kPasTokenTypeRCurly;
-          token.text = LexerText(&lexer, &token);
-          LEXER_NEXT(&lexer);
-          break;
-        case '(':
-          if (LEXER_PEEK(&lexer) == '*') {
-            LEXER_NEXT(&lexer);
-            LEXER_NEXT(&lexer);
-            while (LEXER_CUR(&lexer) != '*' || LEXER_PEEK(&lexer) != ')') {
-              if (LEXER_PEEK(&lexer) == '\0') {
-                break;
-              }
-              LEXER_NEXT(&lexer);
-            }
-            LEXER_NEXT(&lexer);
-            LEXER_NEXT(&lexer);
-            token.type = kPasTokenTypeComment2;
-          } else if (LEXER_PEEK(&lexer) == '.') {
-            LEXER_NEXT(&lexer);
-            LEXER_NEXT(&lexer);
-            token.type = kPasTokenTypeLBracket2;
-          } else {
-            LEXER_NEXT(&lexer);
-            token.type = kPasTokenTypeLParen;
-          }
-          token.text = LexerText(&lexer, &token);
-          break;
-        case '.':
-          if (LEXER_PEEK(&lexer) == '.') {
-            LEXER_NEXT(&lexer);
-            LEXER_NEXT(&lexer);
-            token.type = kPasTokenTypeDotDot;
-          } else if (LEXER_PEEK(&lexer) == ')') {
-            LEXER_NEXT(&lexer);
-            LEXER_NEXT(&lexer);
-            token.type = kPasTokenTypeRBracket2;
-          } else {
-            LEXER_NEXT(&lexer);
-            token.type = kPasTokenTypeDot;
-          }
-          token.text = LexerText(&lexer, &token);
-          break;
-        case '@':
-          LEXER_NEXT(&lexer);
-          token.type = kPasTokenTypeAt;
-          token.text = LexerText(&lexer, &token);
-          break;
-        case '^':
-          LEXER_NEXT(&lexer);
-          token.type = kPasTokenTypePointer;
-          token.text = LexerText(&lexer, &token);
-          break;
-        case '[':
-          LEXER_NEXT(&lexer);
-          token.type = kPasTokenTypeLBracket;
-          token.text = LexerText(&lexer, &token);
-          break;
-        case ']':
-          LEXER_NEXT(&lexer);
-          token.type = kPasTokenTypeRBracket;
-          token.text = LexerText(&lexer, &token);
-          break;
-        case ')':
-          LEXER_NEXT(&lexer);
-          token.type = kPasTokenTypeRParen;
-          token.text = LexerText(&lexer, &token);
-          break;
-        case '>':
-          if (LEXER_PEEK(&lexer) == '=') {
-            LEXER_NEXT(&lexer);
-            LEXER_NEXT(&lexer);
-            token.type = kPasTokenTypeGe;
-          } else {
-            LEXER_NEXT(&lexer);
-            token.type = kPasTokenTypeGt;
-          }
-          token.text = LexerText(&lexer, &token);
-          break;
-        case '<':
-          if (LEXER_PEEK(&lexer) == '=') {
-            LEXER_NEXT(&lexer);
-            LEXER_NEXT(&lexer);
-            token.type = kPasTokenTypeLe;
-          } else if (LEXER_PEEK(&lexer) == '>') {
-            LEXER_NEXT(&lexer);
-            LEXER_NEXT(&lexer);
-            token.type = kPasTokenTypeNotEqual;
-          } else {
-            LEXER_NEXT(&lexer);
-            token.type = kPasTokenTypeLt;
-          }
-          token.text = LexerText(&lexer, &token);
-          break;
-        case '=':
-          LEXER_NEXT(&lexer);
-          token.type = kPasTokenTypeEqual;
-          token.text = LexerText(&lexer, &token);
-          break;
-        case ':':
-          if (LEXER_PEEK(&lexer) == '=') {
-            LEXER_NEXT(&lexer);
-            LEXER_NEXT(&lexer);
-            token.type = kPasTokenTypeAssign;
-          } else {
-            LEXER_NEXT(&lexer);
-            token.type = kPasTokenTypeColon;
-          }
-          token.text = LexerText(&lexer, &token);
-          break;
-        case ';':
-          LEXER_NEXT(&lexer);
-          token.type = kPasTokenTypeSemi;
-          token.text = LexerText(&lexer, &token);
-          break;
-        case ',':
-          LEXER_NEXT(&lexer);
-          token.type = kPasTokenTypeComma;
-          token.text = LexerText(&lexer, &token);
-          break;
-        case '/':
-          LEXER_NEXT(&lexer);
-          token.type = kPasTokenTypeSlash;
-          token.text = LexerText(&lexer, &token);
-          break;
-        case '*':
-          LEXER_NEXT(&lexer);
-          token.type = kPasTokenTypeStar;
-          token.text = LexerText(&lexer, &token);
-          break;
-        case '+':
-          LEXER_NEXT(&lexer);
-          token.type = kPasTokenTypePlus;
-          token.text = LexerText(&lexer, &token);
-          break;
-        case '-':
-          LEXER_NEXT(&lexer);
-          token.type = kPasTokenTypeMinus;
-          token.text = LexerText(&lexer, &token);
-          break;
-        case '\'':
-          LEXER_NEXT(&lexer);
-          while (LEXER_CUR(&lexer) != '\'' ||
-                 LEXER_CUR(&lexer) == '\'' && LEXER_PEEK(&lexer) == '\'') {
-            if (LEXER_CUR(&lexer) == '\0') {
-              break;
-            }
-            LEXER_NEXT(&lexer);
-          }
-          LEXER_NEXT(&lexer);
-          token.type = kPasTokenTypeStringLiteral;
-          token.text = LexerText(&lexer, &token);
-        default:
-          LEXER_NEXT(&lexer);
-          break;
-      }
+      stream->positions.size = size;
+      stream->lengths.size = size;
     }
-    VEC_PUSH(&tokens, token);
   }
-  CleanupKeywords(keywords);
-  return tokens;
+  return pushed;
+}
+
+void PasTokenStreamFree(PasTokenStream* stream) {
+  VEC_FREE(&stream->types);
+  VEC_FREE(&stream->positions);
+  VEC_FREE(&stream->lengths);
+  VEC_FREE(&stream->positions64);
+  VEC_FREE(&stream->lengths64);
+  VEC_FREE(&stream->symbols);
+}
+
+void PasTriviaFree(PasTrivia* trivia) {
+  PasTokenStreamFree(&trivia->tokens);
+  VEC_FREE(&trivia->starts);
+}
+
+void PasLexSinkInit(PasLexSink* sink,
+                    PasTokenStream* tokens,
+                    const PasSource* source,
+                    const PasLexOptions* options) {
+  bool wide = source->size > UINT32_MAX;
+  PasTokenStreamInit(tokens, wide, options->allocator);
+  tokens->interner = options->interner;
+  *sink = (PasLexSink){
+      .tokens = tokens,
+      .text = PasSourceView(source),
+      .mode = options->trivia,
+      .trivia = options->attached,
+  };
+  if (sink->mode == kPasTriviaAttach && sink->trivia == NULL) {
+    sink->mode = kPasTriviaDrop;
+  }
+  // A failed reservation is not an error: pushes grow the arrays as usual.
+  uint64_t all = source->size / LEX_BYTES_PER_TOKEN + 1;
+  uint64_t significant = source->size / LEX_BYTES_PER_SIGNIFICANT_TOKEN + 1;
+  PasTokenStreamReserve(tokens,
+                        sink->mode == kPasTriviaKeep ? all : significant);
+  if (sink->mode == kPasTriviaAttach) {
+    *sink->trivia = (PasTrivia){0};
+    PasTokenStreamInit(&sink->trivia->tokens, wide, options->allocator);
+    VEC_SET_ALLOCATOR(&sink->trivia->starts,
+                      LEX_STATS_ALLOCATOR(options->allocator));
+    PasTokenStreamReserve(&sink->trivia->tokens, all - significant);
+    VEC_RESERVE(&sink->trivia->starts, significant + 2);
+    VEC_PUSH(&sink->trivia->starts, 0);
+  }
+}
+
+bool PasLexSinkPush(PasLexSink* sink, const PasToken* token) {
+  // Chunks lexed in parallel cannot share the interner, so their
+  // identifiers are interned here, in order. The interner gives
+  // PAS_NO_SYMBOL when it runs out of memory or symbols.
+  PasToken interned;
+  if (sink->tokens->interner != NULL && token->type == kPasTokenTypeIdent &&
+      token->symbol == PAS_NO_SYMBOL) {
+    interned = *token;
+    const char* text = sink->text.data + token->position;
+    interned.symbol =
+        PasInternerAdd(sink->tokens->interner, text, token->length,
+                       PasInternHash(text, token->length));
+    if (interned.symbol == PAS_NO_SYMBOL) {
+      return PasLexSinkFail(sink);
+    }
+    token = &interned;
+  }
+  bool pushed = true;
+  if (sink->mode == kPasTriviaKeep || !PasTokenTypeIsTrivia(token->type)) {
+    pushed = PasTokenStreamPush(sink->tokens, token) &&
+             (sink->mode != kPasTriviaAttach ||
+              VEC_PUSH(&sink->trivia->starts,
+                       PasTokenStreamSize(&sink->trivia->tokens)));
+  } else if (sink->mode == kPasTriviaAttach) {
+    pushed = PasTokenStreamPush(&sink->trivia->tokens, token);
+  }
+  return pushed || PasLexSinkFail(sink);
+}
+
+bool PasLexSinkFinish(PasLexSink* sink) {
+  LEX_STATS_FLUSH();
+  if (sink->mode == kPasTriviaAttach &&
+      !VEC_PUSH(&sink->trivia->starts,
+                PasTokenStreamSize(&sink->trivia->tokens))) {
+    return PasLexSinkFail(sink);
+  }
+  return sink->tokens->error == 0;
 }
 
-String LexerText(Lexer* lexer, PasToken* token) {
-  return StringMake(lexer->text.data + token->position,
-                    lexer->text.data + lexer->position);
+bool PasLexSinkFail(PasLexSink* sink) {
+  sink->tokens->error = ENOMEM;
+  return false;
 }
 
-void LexExponent(Lexer* lexer) {
-  LEXER_NEXT(lexer);
-  if (IsSign(LEXER_CUR(lexer))) {
+// Hashes the identifier in the loop that scans it, so interning costs no
+// second pass over its text.
+void LexInternedIdentifier(PasLexer* lexer, PasToken* token) {
+  uint64_t hash = PAS_INTERN_HASH_SEED;
+  while (IsIdentifierPart(LEXER_CUR(lexer))) {
+    hash = PasInternHashStep(hash, LEXER_CUR(lexer));
     LEXER_NEXT(lexer);
   }
-  while (IsDigit(LEXER_CUR(lexer))) {
+  const char* text = lexer->text.data + token->position;
+  uint64_t length = lexer->position - token->position;
+  token->type = PasKeywordLookup(text, length);
+  if (token->type == kPasTokenTypeIdent) {
+    token->symbol = PasInternerAdd(lexer->interner, text, length, hash);
+  }
+}
+
+// Takes the two-byte token if the next byte completes one, else the one-byte
+// token, with two table loads and no comparisons.
+void LexOperator(PasLexer* lexer, PasToken* token) {
+  uint8_t first = (uint8_t)LEXER_CUR(lexer);
+  PasTokenType pair = kLexPair[kLexPairRow[first]][(uint8_t)LEXER_PEEK(lexer)];
+  if (pair == kPasTokenTypeZero) {
     LEXER_NEXT(lexer);
+    token->type = kLexSingle[first];
+    return;
+  }
+  lexer->position += 2;
+  token->type = pair;
+  if (pair == kPasTokenTypeComment2) {
+    lexer->position = PasLexParenCommentEnd(lexer, lexer->position);
   }
 }
 
-void AddKeyword(LexerKeyword** keywords, String text, PasTokenType type) {
-  LexerKeyword* keyword = (LexerKeyword*)malloc(sizeof(LexerKeyword));
-  keyword->text = text;
-  keyword->type = type;
-  HASH_ADD_KEYPTR(hh, *keywords, keyword->text.data, keyword->text.size,
-                  keyword);
+uint64_t PasLexQuoteEnd(const PasLexer* lexer, uint64_t from) {
+  uint64_t end = from;
+  while (true) {
+    end = LEXER_SCAN(lexer, quote, LEXER_AT(lexer, end));
+    if (lexer->text.data[end] == '\'') {
+      if (lexer->text.data[end + 1] != '\'') {
+        return end + 1;
+      }
+      end += 2;
+    } else if (end >= lexer->text.size) {
+      return end;
+    } else {
+      end++;
+    }
+  }
 }
 
-void CleanupKeywords(LexerKeyword* keywords) {
-  LexerKeyword* kw;
-  LexerKeyword* tmp;
-  HASH_ITER(hh, keywords, kw, tmp) {
-    HASH_DEL(keywords, kw);
-    VEC_FREE(&kw->text);
-    free(kw);
+uint64_t PasLexBraceCommentEnd(const PasLexer* lexer, uint64_t from) {
+  uint64_t end = from;
+  while (true) {
+    end = LEXER_SCAN(lexer, brace_comment, LEXER_AT(lexer, end));
+    if (lexer->text.data[end] == '}') {
+      return end + 1;
+    }
+    if (end >= lexer->text.size) {
+      return end;
+    }
+    end++;
   }
 }
 
-bool IsIdentifierStart(char c) {
-  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+uint64_t PasLexParenCommentEnd(const PasLexer* lexer, uint64_t from) {
+  uint64_t end = from;
+  while (true) {
+    end = LEXER_SCAN(lexer, paren_comment, LEXER_AT(lexer, end));
+    if (lexer->text.data[end] == '*' && lexer->text.data[end + 1] == ')') {
+      return end + 2;
+    }
+    if (end >= lexer->text.size) {
+      return end;
+    }
+    end++;
+  }
 }
 
-bool IsDigit(char c) {
-  return c >= '0' && c <= '9';
+// Consumes an exponent only if it has digits, so that 1e and 1e+ end at 1.
+bool LexExponent(PasLexer* lexer) {
+  if ((LEXER_CUR(lexer) | 0x20) != 'e') {
+    return false;
+  }
+  uint64_t digits = IsSign(LEXER_PEEK(lexer)) ? 2 : 1;
+  if (!IsDigit(LEXER_LOOK(lexer, digits))) {
+    return false;
+  }
+  lexer->position += digits;
+  while (IsDigit(LEXER_CUR(lexer))) {
+    LEXER_NEXT(lexer);
+  }
+  return true;
 }
 
 bool IsIdentifierPart(char c) {
-  return IsIdentifierStart(c) || IsDigit(c) || c == '_';
+  LexClass class = kLexClass[(uint8_t)c];
+  return class == kLexClassIdentifier || class == kLexClassDigit || c == '_';
 }
 
-bool IsSign(char c) {
-  return c == '+' || c == '-';
+bool IsDigit(char c) {
+  return c >= '0' && c <= '9';
 }
 
-bool IsWhiteSpace(char c) {
-  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+bool IsSign(char c) {
+  return c == '+' || c == '-';
 }
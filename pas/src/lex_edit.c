@@ -0,0 +1,181 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "pas/lex.h"
+
+// A token's end can depend on up to two bytes past it, as with 1e+5.
+#define RELEX_LOOKAHEAD 3
+
+static uint64_t FindRestart(const PasTokenStream* tokens, uint64_t start);
+static bool FindOldToken(const PasTokenStream* tokens,
+                         uint64_t low,
+                         uint64_t position,
+                         uint64_t* index);
+static void Splice(VecUnpacked v,
+                   uint64_t from,
+                   uint64_t to,
+                   const void* data,
+                   uint64_t count);
+static void ShiftPositions(PasTokenStream* tokens,
+                           uint64_t from,
+                           int64_t delta);
+
+bool PasRelex(PasTokenStream* tokens,
+              const PasSource* source,
+              uint64_t start,
+              uint64_t removed,
+              uint64_t inserted) {
+  if (!tokens->wide && source->size > UINT32_MAX) {
+    const VecAllocator* allocator = tokens->types.allocator;
+    PasInterner* interner = tokens->interner;
+    PasTokenStreamFree(tokens);
+    *tokens = PasLexWithOptions(
+        source,
+        &(PasLexOptions){.allocator = allocator, .interner = interner});
+    return tokens->error == 0;
+  }
+  int64_t delta = (int64_t)inserted - (int64_t)removed;
+  uint64_t old_count = PasTokenStreamSize(tokens);
+  // Bytes before the edit are unchanged, so the old stream can be searched
+  // with the new text for everything that ends before `start`.
+  uint64_t restart = FindRestart(tokens, start);
+  uint64_t resume = old_count;
+  PasTokenStream fresh;
+  PasTokenStreamInit(&fresh, tokens->wide, NULL);
+  fresh.interner = tokens->interner;
+  PasLexer lexer;
+  PasLexerInit(&lexer, source);
+  lexer.interner = tokens->interner;
+  lexer.position =
+      restart < old_count ? PasTokenStreamPosition(tokens, restart) : 0;
+  PasToken token;
+  while (true) {
+    if (lexer.position >= start + inserted &&
+        FindOldToken(tokens, restart, lexer.position - delta, &resume)) {
+      break;
+    }
+    if (!PasLexerNext(&lexer, &token)) {
+      resume = old_count;
+      break;
+    }
+    // The lexer leaves an identifier without a symbol when interning fails.
+    if ((tokens->interner != NULL && token.type == kPasTokenTypeIdent &&
+         token.symbol == PAS_NO_SYMBOL) ||
+        !PasTokenStreamPush(&fresh, &token)) {
+      PasLexerFinish(&lexer);
+      PasTokenStreamFree(&fresh);
+      return false;
+    }
+  }
+  PasLexerFinish(&lexer);
+  uint64_t count = PasTokenStreamSize(&fresh);
+  VecUnpacked arrays[4] = {VEC_UNPACK(&tokens->types)};
+  const void* data[4] = {fresh.types.data};
+  int array_count = 1;
+  if (tokens->wide) {
+    arrays[array_count] = VEC_UNPACK(&tokens->positions64);
+    data[array_count++] = fresh.positions64.data;
+    arrays[array_count] = VEC_UNPACK(&tokens->lengths64);
+    data[array_count++] = fresh.lengths64.data;
+  } else {
+    arrays[array_count] = VEC_UNPACK(&tokens->positions);
+    data[array_count++] = fresh.positions.data;
+    arrays[array_count] = VEC_UNPACK(&tokens->lengths);
+    data[array_count++] = fresh.lengths.data;
+  }
+  if (tokens->interner != NULL) {
+    arrays[array_count] = VEC_UNPACK(&tokens->symbols);
+    data[array_count++] = fresh.symbols.data;
+  }
+  // Every array is grown before any is changed, so running out of memory
+  // leaves them all as they were.
+  uint64_t size = old_count - (resume - restart) + count;
+  for (int i = 0; i < array_count; ++i) {
+    if (!VecReserve(arrays[i], size)) {
+      PasTokenStreamFree(&fresh);
+      return false;
+    }
+  }
+  for (int i = 0; i < array_count; ++i) {
+    Splice(arrays[i], restart, resume, data[i], count);
+  }
+  PasTokenStreamFree(&fresh);
+  ShiftPositions(tokens, restart + count, delta);
+  return true;
+}
+
+// Returns the first token that must be lexed again: the one holding the
+// byte RELEX_LOOKAHEAD before the edit, since it may have looked into the
+// edit.
+uint64_t FindRestart(const PasTokenStream* tokens, uint64_t start) {
+  uint64_t count = PasTokenStreamSize(tokens);
+  if (start < RELEX_LOOKAHEAD || count == 0) {
+    return 0;
+  }
+  uint64_t low = 0;
+  uint64_t high = count;
+  while (high - low > 1) {
+    uint64_t mid = low + (high - low) / 2;
+    if (PasTokenStreamPosition(tokens, mid) <= start - RELEX_LOOKAHEAD) {
+      low = mid;
+    } else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+bool FindOldToken(const PasTokenStream* tokens,
+                  uint64_t low,
+                  uint64_t position,
+                  uint64_t* index) {
+  uint64_t high = PasTokenStreamSize(tokens);
+  while (low < high) {
+    uint64_t mid = low + (high - low) / 2;
+    uint64_t mid_position = PasTokenStreamPosition(tokens, mid);
+    if (mid_position == position) {
+      *index = mid;
+      return true;
+    }
+    if (mid_position < position) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return false;
+}
+
+// Replaces elements [from, to) of `v` with `count` elements from `data`. `v`
+// must already have room for the result.
+void Splice(VecUnpacked v,
+            uint64_t from,
+            uint64_t to,
+            const void* data,
+            uint64_t count) {
+  uint64_t tail = *v.size - to;
+  uint64_t size = from + count + tail;
+  uint8_t* base = *v.data;
+  if (tail > 0) {
+    memmove(base + (from + count) * v.sizeof_t, base + to * v.sizeof_t,
+            tail * v.sizeof_t);
+  }
+  if (count > 0) {
+    memcpy(base + from * v.sizeof_t, data, count * v.sizeof_t);
+  }
+  *v.size = size;
+}
+
+void ShiftPositions(PasTokenStream* tokens, uint64_t from, int64_t delta) {
+  uint64_t count = PasTokenStreamSize(tokens);
+  if (tokens->wide) {
+    for (uint64_t i = from; i < count; ++i) {
+      tokens->positions64.data[i] += (uint64_t)delta;
+    }
+  } else {
+    for (uint64_t i = from; i < count; ++i) {
+      tokens->positions.data[i] += (uint32_t)delta;
+    }
+  }
+}
@@ -0,0 +1,297 @@
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lex_run.h"
+#include "lex_sink.h"
+#include "lex_stats.h"
+#include "pas/lex.h"
+
+#ifndef PARALLEL_MIN_CHUNK
+#define PARALLEL_MIN_CHUNK (256 * 1024)
+#endif
+
+#define NO_JOIN UINT32_MAX
+
+// The state a chunk's first byte might be in. Each guess gives a candidate
+// start position; which one is right is only known once the previous chunk
+// has been stitched.
+typedef enum {
+  kChunkStateCode,
+  kChunkStateString,
+  kChunkStateBraceComment,
+  kChunkStateParenComment,
+  kChunkStateCount,
+} ChunkState;
+
+// Tokens lexed from one guessed start. A candidate stops early once one of
+// its token boundaries lines up with an earlier candidate's, since the lexer
+// is stateless at a token boundary; the rest of it is that candidate from
+// `join_index` on.
+typedef struct {
+  PasTokenStream tokens;
+  uint32_t join_candidate;
+  uint64_t join_index;
+} Candidate;
+
+typedef struct {
+  const PasSource* source;
+  uint64_t begin;
+  uint64_t end;
+  // Set when a candidate could not store a token, so the chunk cannot be
+  // stitched.
+  bool failed;
+  uint32_t candidate_count;
+  Candidate candidates[kChunkStateCount];
+} Chunk;
+
+static void* LexChunk(void* arg);
+static uint64_t GuessStart(const PasSource* source,
+                           uint64_t begin,
+                           ChunkState state);
+static bool FindJoin(const Chunk* chunk,
+                     uint32_t count,
+                     uint64_t position,
+                     uint32_t* candidate,
+                     uint64_t* index);
+static bool FindPosition(const PasTokenStream* tokens,
+                         uint64_t position,
+                         uint64_t* index);
+static bool StitchChunk(PasLexSink* out,
+                        const Chunk* chunk,
+                        uint64_t* position);
+static bool AppendCandidate(PasLexSink* out,
+                            const Chunk* chunk,
+                            uint32_t candidate,
+                            uint64_t index,
+                            uint64_t* end);
+
+PasTokenStream PasLexParallel(const PasSource* source,
+                              const PasLexOptions* options) {
+  uint64_t chunk_count = options->threads;
+  if (source->size / PARALLEL_MIN_CHUNK < chunk_count) {
+    chunk_count = source->size / PARALLEL_MIN_CHUNK;
+  }
+  PasTokenStream out;
+  PasLexSink sink;
+  PasLexSinkInit(&sink, &out, source, options);
+  Chunk* chunks = calloc(chunk_count, sizeof(Chunk));
+  pthread_t* threads = calloc(chunk_count, sizeof(pthread_t));
+  bool* started = calloc(chunk_count, sizeof(bool));
+  if (chunk_count <= 1 || chunks == NULL || threads == NULL ||
+      started == NULL) {
+    free(chunks);
+    free(threads);
+    free(started);
+    PasLexer lexer;
+    PasLexerInit(&lexer, source);
+    lexer.interner = options->interner;
+    PasToken token;
+    while (PasLexerNext(&lexer, &token)) {
+      if (!PasLexSinkPush(&sink, &token)) {
+        break;
+      }
+    }
+    PasLexSinkFinish(&sink);
+    PasLexerFinish(&lexer);
+    return out;
+  }
+  for (uint64_t i = 0; i < chunk_count; ++i) {
+    chunks[i] = (Chunk){
+        .source = source,
+        .begin = source->size * i / chunk_count,
+        .end = source->size * (i + 1) / chunk_count,
+    };
+    if (i > 0) {
+      started[i] =
+          pthread_create(&threads[i], NULL, LexChunk, &chunks[i]) == 0;
+    }
+  }
+  LexChunk(&chunks[0]);
+  uint64_t position = 0;
+  bool stitched = true;
+  for (uint64_t i = 0; i < chunk_count; ++i) {
+    if (i > 0) {
+      if (started[i]) {
+        pthread_join(threads[i], NULL);
+      } else if (stitched) {
+        LexChunk(&chunks[i]);
+      }
+    }
+    if (stitched && chunks[i].failed) {
+      stitched = PasLexSinkFail(&sink);
+    }
+    stitched = stitched && StitchChunk(&sink, &chunks[i], &position);
+    for (uint32_t j = 0; j < chunks[i].candidate_count; ++j) {
+      PasTokenStreamFree(&chunks[i].candidates[j].tokens);
+    }
+  }
+  PasLexSinkFinish(&sink);
+  free(chunks);
+  free(threads);
+  free(started);
+  return out;
+}
+
+void* LexChunk(void* arg) {
+  Chunk* chunk = arg;
+  const PasSource* source = chunk->source;
+  uint32_t states = chunk->begin == 0 ? 1 : kChunkStateCount;
+  for (uint32_t state = 0; state < states && !chunk->failed; ++state) {
+    Candidate* candidate = &chunk->candidates[chunk->candidate_count];
+    *candidate = (Candidate){.join_candidate = NO_JOIN};
+    PasTokenStreamInit(&candidate->tokens, source->size > UINT32_MAX, NULL);
+    chunk->candidate_count++;
+    PasLexer lexer;
+    PasLexerInit(&lexer, source);
+    lexer.position = GuessStart(source, chunk->begin, (ChunkState)state);
+    PasToken token;
+    while (lexer.position < chunk->end) {
+      if (FindJoin(chunk, chunk->candidate_count - 1, lexer.position,
+                   &candidate->join_candidate, &candidate->join_index)) {
+        break;
+      }
+      if (!PasLexStep(&lexer, &token)) {
+        break;
+      }
+      if (!PasTokenStreamPush(&candidate->tokens, &token)) {
+        chunk->failed = true;
+        break;
+      }
+    }
+    PasLexerFinish(&lexer);
+  }
+  return NULL;
+}
+
+uint64_t GuessStart(const PasSource* source,
+                    uint64_t begin,
+                    ChunkState state) {
+  const char* data = source->data;
+  uint64_t size = source->size;
+  const PasScanKernels* scan = PasScanKernelsBest();
+  uint64_t p = begin;
+  switch (state) {
+    case kChunkStateCode:
+      return begin;
+    case kChunkStateString:
+      while (p < size) {
+        if (data[p] == '\'') {
+          if (data[p + 1] != '\'') {
+            return p + 1;
+          }
+          p++;
+        }
+        p++;
+      }
+      return size;
+    case kChunkStateBraceComment:
+      p = (uint64_t)(scan->brace_comment(data + p) - data);
+      while (p < size && data[p] != '}') {
+        p = (uint64_t)(scan->brace_comment(data + p + 1) - data);
+      }
+      return p < size ? p + 1 : size;
+    case kChunkStateParenComment:
+      p = begin > 0 ? begin - 1 : 0;
+      while (true) {
+        p = (uint64_t)(scan->paren_comment(data + p) - data);
+        if (p >= size) {
+          return size;
+        }
+        if (data[p] == '*' && data[p + 1] == ')') {
+          return p + 2;
+        }
+        p++;
+      }
+    default:
+      return size;
+  }
+}
+
+bool FindJoin(const Chunk* chunk,
+              uint32_t count,
+              uint64_t position,
+              uint32_t* candidate,
+              uint64_t* index) {
+  for (uint32_t i = 0; i < count; ++i) {
+    if (FindPosition(&chunk->candidates[i].tokens, position, index)) {
+      *candidate = i;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool FindPosition(const PasTokenStream* tokens,
+                  uint64_t position,
+                  uint64_t* index) {
+  uint64_t low = 0;
+  uint64_t high = PasTokenStreamSize(tokens);
+  while (low < high) {
+    uint64_t mid = low + (high - low) / 2;
+    uint64_t mid_position = PasTokenStreamPosition(tokens, mid);
+    if (mid_position == position) {
+      *index = mid;
+      return true;
+    }
+    if (mid_position < position) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return false;
+}
+
+// Appends the tokens of `chunk` that start at or after `*position`, the end
+// of the last stitched token, and moves it to the end of the last appended
+// token. When no candidate has a boundary at `*position` (a guess was wrong,
+// or the previous chunk's last token ran into this one), it lexes from there
+// until it reaches a candidate boundary or the end of the chunk. Returns false
+// if the sink fails.
+bool StitchChunk(PasLexSink* out, const Chunk* chunk, uint64_t* position) {
+  PasLexer lexer;
+  PasLexerInit(&lexer, chunk->source);
+  lexer.position = *position;
+  PasToken token;
+  bool ok = true;
+  while (ok && lexer.position < chunk->end) {
+    uint32_t candidate;
+    uint64_t index;
+    if (FindJoin(chunk, chunk->candidate_count, lexer.position, &candidate,
+                 &index)) {
+      ok = AppendCandidate(out, chunk, candidate, index, &lexer.position);
+      break;
+    }
+    if (!PasLexerNext(&lexer, &token)) {
+      break;
+    }
+    ok = PasLexSinkPush(out, &token);
+  }
+  *position = lexer.position;
+  PasLexerFinish(&lexer);
+  return ok;
+}
+
+bool AppendCandidate(PasLexSink* out,
+                     const Chunk* chunk,
+                     uint32_t candidate,
+                     uint64_t index,
+                     uint64_t* end) {
+  while (candidate != NO_JOIN) {
+    const Candidate* c = &chunk->candidates[candidate];
+    for (uint64_t i = index; i < PasTokenStreamSize(&c->tokens); ++i) {
+      PasToken token = PasTokenStreamGet(&c->tokens, i);
+      LEX_STATS_TOKEN(&token);
+      if (!PasLexSinkPush(out, &token)) {
+        return false;
+      }
+      *end = token.position + token.length;
+    }
+    candidate = c->join_candidate;
+    index = c->join_index;
+  }
+  return true;
+}
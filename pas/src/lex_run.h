@@ -0,0 +1,18 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "pas/lex.h"
+
+// Lexes the next token like PasLexerNext but leaves it out of the token
+// counts, for callers that may lex it again or throw it away; they count the
+// tokens they hand out with LEX_STATS_TOKEN.
+bool PasLexStep(PasLexer* lexer, PasToken* token);
+// Return the end of the string or comment body that starts at `from`, which
+// is just past the opening delimiter or anywhere later in the body that is
+// not between the two bytes of a doubled quote or a closing *). The
+// streaming lexer uses them to resume a body cut off by the end of a chunk.
+uint64_t PasLexQuoteEnd(const PasLexer* lexer, uint64_t from);
+uint64_t PasLexBraceCommentEnd(const PasLexer* lexer, uint64_t from);
+uint64_t PasLexParenCommentEnd(const PasLexer* lexer, uint64_t from);
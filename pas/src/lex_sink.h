@@ -0,0 +1,26 @@
+#pragma once
+
+#include <stdbool.h>
+
+#include "pas/lex.h"
+
+// Sends lexed tokens to the output stream, or to the trivia side table,
+// according to PasLexOptions::trivia.
+typedef struct {
+  PasTokenStream* tokens;
+  StringView text;
+  PasTriviaMode mode;
+  PasTrivia* trivia;
+} PasLexSink;
+
+// Initializes `tokens`, and the attached trivia if any, for `source`.
+void PasLexSinkInit(PasLexSink* sink,
+                    PasTokenStream* tokens,
+                    const PasSource* source,
+                    const PasLexOptions* options);
+// Both return false, with the stream's error set, once a token cannot be
+// stored; the caller should stop lexing.
+bool PasLexSinkPush(PasLexSink* sink, const PasToken* token);
+bool PasLexSinkFinish(PasLexSink* sink);
+// Sets the stream's error for a failure outside the sink and returns false.
+bool PasLexSinkFail(PasLexSink* sink);
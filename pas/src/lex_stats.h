@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "pas/lex.h"
+#include "pas/stats.h"
+
+// Each thread counts into its own PasLexStats and adds it to the totals when
+// a lexer finishes, so the hot path takes no lock. Allocations are rare and go
+// straight to the totals, whichever thread makes them.
+//
+// Time is counted where a token is lexed and the token itself where it is
+// handed out, so that tokens lexed twice or thrown away, as the streaming and
+// parallel lexers do, cost time but are counted once.
+#ifdef PAS_STATS
+#define LEX_STATS_START(Name) uint64_t Name = PasLexStatsTicks()
+#define LEX_STATS_TIME(Token, Start) PasLexStatsTime((Token), (Start))
+#define LEX_STATS_TOKEN(Token) PasLexStatsToken(Token)
+#define LEX_STATS_ALLOCATOR(Allocator) PasLexStatsAllocator(Allocator)
+#define LEX_STATS_FLUSH() PasLexStatsFlush()
+
+extern _Thread_local PasLexStats pas_lex_stats_local;
+
+uint64_t PasLexStatsTicks(void);
+void PasLexStatsFlush(void);
+// Returns an allocator that counts into the totals and passes the calls on to
+// `allocator`, or to realloc/free if it is NULL.
+const VecAllocator* PasLexStatsAllocator(const VecAllocator* allocator);
+
+static inline void PasLexStatsTime(const PasToken* token, uint64_t start) {
+  PasLexBranch branch = PasLexBranchOf(token->type);
+  pas_lex_stats_local.branch_ticks[branch] += PasLexStatsTicks() - start;
+}
+
+static inline void PasLexStatsToken(const PasToken* token) {
+  PasLexStats* stats = &pas_lex_stats_local;
+  PasLexBranch branch = PasLexBranchOf(token->type);
+  stats->tokens[token->type]++;
+  stats->bytes[token->type] += token->length;
+  stats->branch_tokens[branch]++;
+  if (branch == kPasLexBranchIdentifier) {
+    stats->keyword_hits += token->type != kPasTokenTypeIdent;
+    stats->keyword_misses += token->type == kPasTokenTypeIdent;
+  }
+}
+#else
+#define LEX_STATS_START(Name) ((void)0)
+#define LEX_STATS_TIME(Token, Start) ((void)0)
+#define LEX_STATS_TOKEN(Token) ((void)0)
+#define LEX_STATS_ALLOCATOR(Allocator) (Allocator)
+#define LEX_STATS_FLUSH() ((void)0)
+#endif
@@ -0,0 +1,217 @@
+#include "pas/lex_stream.h"
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "lex_run.h"
+#include "lex_stats.h"
+#include "pas/keyword.h"
+#include "pas/source.h"
+
+// A number's end depends on up to three bytes past it, as with 1e+5; any
+// other token's on at most the byte after it.
+#define STREAM_NUMBER_LOOKAHEAD 3
+
+static bool StreamIsFinal(const PasStreamLexer* lexer, const PasToken* token);
+static void StreamSuspend(PasStreamLexer* lexer, const PasToken* token);
+static PasToken StreamResume(PasStreamLexer* lexer);
+static bool StreamFill(PasStreamLexer* lexer);
+
+bool PasStreamLexerInit(PasStreamLexer* lexer, int fd, uint64_t chunk_size) {
+  if (chunk_size == 0) {
+    chunk_size = PAS_STREAM_DEFAULT_CHUNK;
+  }
+  *lexer = (PasStreamLexer){
+      .fd = fd,
+      .buffer = calloc(chunk_size + PAS_SOURCE_PADDING, 1),
+      .capacity = chunk_size,
+      .chunk_size = chunk_size,
+  };
+  if (lexer->buffer == NULL) {
+    errno = ENOMEM;
+    return false;
+  }
+  PasLexerInit(&lexer->lexer,
+               &(PasSource){.data = lexer->buffer, .size = 0});
+  return true;
+}
+
+bool PasStreamLexerNext(PasStreamLexer* lexer,
+                        PasToken* token,
+                        StringView* text) {
+  while (true) {
+    PasToken next;
+    if (lexer->pending != kPasTokenTypeZero) {
+      next = StreamResume(lexer);
+    } else if (!PasLexStep(&lexer->lexer, &next)) {
+      if (lexer->eof || !StreamFill(lexer)) {
+        return false;
+      }
+      continue;
+    }
+    if (StreamIsFinal(lexer, &next)) {
+      lexer->pending = kPasTokenTypeZero;
+      lexer->lexer.position = next.position + next.length;
+      LEX_STATS_TOKEN(&next);
+      *text = StringViewMake(lexer->buffer + next.position, next.length);
+      next.position += lexer->base;
+      *token = next;
+      return true;
+    }
+    lexer->lexer.position = next.position;
+    StreamSuspend(lexer, &next);
+    if (!StreamFill(lexer)) {
+      return false;
+    }
+  }
+}
+
+void PasStreamLexerFinish(PasStreamLexer* lexer) {
+  PasLexerFinish(&lexer->lexer);
+  free(lexer->buffer);
+  *lexer = (PasStreamLexer){0};
+}
+
+// The window ends in NUL padding, which stops every token; a token that ends
+// too close to it may still grow once the next chunk is read, unless it is a
+// comment that ends with its closing delimiter.
+bool StreamIsFinal(const PasStreamLexer* lexer, const PasToken* token) {
+  const char* data = lexer->buffer;
+  uint64_t end = token->position + token->length;
+  uint64_t lookahead = 1;
+  switch (token->type) {
+    case kPasTokenTypeComment1:
+      if (data[end - 1] == '}') {
+        return true;
+      }
+      break;
+    case kPasTokenTypeComment2:
+      if (token->length >= 4 && data[end - 2] == '*' && data[end - 1] == ')') {
+        return true;
+      }
+      break;
+    case kPasTokenTypeNumInt:
+    case kPasTokenTypeNumReal:
+      lookahead = STREAM_NUMBER_LOOKAHEAD;
+      break;
+    default:
+      break;
+  }
+  return lexer->eof || end + lookahead <= lexer->size;
+}
+
+// Records where to continue a token that ran into the end of the window.
+// Numbers and operators are short and are lexed again from their start.
+void StreamSuspend(PasStreamLexer* lexer, const PasToken* token) {
+  const char* data = lexer->buffer;
+  uint64_t start = token->position;
+  uint64_t end = start + token->length;
+  lexer->pending = kPasTokenTypeZero;
+  if (end != lexer->size) {
+    return;
+  }
+  lexer->resume = end;
+  switch (token->type) {
+    case kPasTokenTypeWs:
+    case kPasTokenTypeComment1:
+      lexer->pending = token->type;
+      break;
+    case kPasTokenTypeComment2:
+      // The last byte may be the '*' of the closing *).
+      lexer->pending = token->type;
+      if (end - 1 >= start + 2) {
+        lexer->resume = end - 1;
+      }
+      break;
+    case kPasTokenTypeStringLiteral: {
+      // Quotes pair up from the left, so an odd run of them at the end
+      // leaves the last one unpaired until the next byte is known.
+      uint64_t quotes = 0;
+      while (end - quotes > start + 1 && data[end - quotes - 1] == '\'') {
+        quotes++;
+      }
+      lexer->pending = token->type;
+      lexer->resume = end - quotes % 2;
+    } break;
+    default:
+      if ((uint8_t)((data[start] | 0x20) - 'a') < 26) {
+        lexer->pending = kPasTokenTypeIdent;
+      }
+      break;
+  }
+}
+
+PasToken StreamResume(PasStreamLexer* lexer) {
+  const PasLexer* inner = &lexer->lexer;
+  const char* data = lexer->buffer;
+  PasToken token = {
+      .position = inner->position,
+      .type = lexer->pending,
+      .symbol = PAS_NO_SYMBOL,
+  };
+  uint64_t end = lexer->resume;
+  switch (lexer->pending) {
+    case kPasTokenTypeWs:
+      end = (uint64_t)(inner->scan->whitespace(data + end) - data);
+      break;
+    case kPasTokenTypeIdent:
+      end = (uint64_t)(inner->scan->identifier(data + end) - data);
+      token.type =
+          PasKeywordLookup(data + token.position, end - token.position);
+      break;
+    case kPasTokenTypeComment1:
+      end = PasLexBraceCommentEnd(inner, end);
+      break;
+    case kPasTokenTypeComment2:
+      end = PasLexParenCommentEnd(inner, end);
+      break;
+    case kPasTokenTypeStringLiteral:
+      end = PasLexQuoteEnd(inner, end);
+      break;
+    default:
+      break;
+  }
+  token.length = end - token.position;
+  return token;
+}
+
+// Drops the bytes before the next token and reads up to a chunk after the
+// rest. The window doubles when the next token leaves less than half a chunk
+// free, so a long token is copied a bounded number of times.
+bool StreamFill(PasStreamLexer* lexer) {
+  uint64_t keep = lexer->lexer.position;
+  memmove(lexer->buffer, lexer->buffer + keep, lexer->size - keep);
+  lexer->base += keep;
+  lexer->size -= keep;
+  lexer->resume -= lexer->pending != kPasTokenTypeZero ? keep : 0;
+  if (lexer->capacity - lexer->size < (lexer->chunk_size + 1) / 2) {
+    uint64_t capacity = lexer->capacity * 2;
+    char* buffer = realloc(lexer->buffer, capacity + PAS_SOURCE_PADDING);
+    if (buffer == NULL) {
+      lexer->error = ENOMEM;
+      return false;
+    }
+    lexer->buffer = buffer;
+    lexer->capacity = capacity;
+  }
+  uint64_t space = lexer->capacity - lexer->size;
+  ssize_t n;
+  do {
+    n = read(lexer->fd, lexer->buffer + lexer->size,
+             space < lexer->chunk_size ? space : lexer->chunk_size);
+  } while (n < 0 && errno == EINTR);
+  if (n < 0) {
+    lexer->error = errno;
+    return false;
+  }
+  lexer->eof = n == 0;
+  lexer->size += (uint64_t)n;
+  memset(lexer->buffer + lexer->size, 0, PAS_SOURCE_PADDING);
+  lexer->lexer.text = StringViewMake(lexer->buffer, lexer->size);
+  lexer->lexer.position = 0;
+  return true;
+}
@@ -0,0 +1,45 @@
+#include "pas/lines.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "lex_stats.h"
+#include "pas/scan.h"
+
+bool PasLineTableBuild(PasLineTable* table, StringView source) {
+  *table = (PasLineTable){0};
+  VEC_SET_ALLOCATOR(&table->starts, LEX_STATS_ALLOCATOR(NULL));
+  const char* end = source.data + source.size;
+  uint64_t lines = 1 + PasScanKernelsBest()->newlines(source.data, end);
+  if (!VEC_RESERVE(&table->starts, lines)) {
+    return false;
+  }
+  table->starts.data[table->starts.size++] = 0;
+  const char* p = source.data;
+  while ((p = memchr(p, '\n', end - p)) != NULL) {
+    table->starts.data[table->starts.size++] = ++p - source.data;
+  }
+  return true;
+}
+
+void PasLineTableFree(PasLineTable* table) {
+  VEC_FREE(&table->starts);
+}
+
+void PasLineTableLookup(const PasLineTable* table,
+                        uint64_t position,
+                        uint64_t* line,
+                        uint64_t* column) {
+  uint64_t low = 0;
+  uint64_t high = table->starts.size;
+  while (high - low > 1) {
+    uint64_t mid = low + (high - low) / 2;
+    if (table->starts.data[mid] <= position) {
+      low = mid;
+    } else {
+      high = mid;
+    }
+  }
+  *line = low + 1;
+  *column = position - table->starts.data[low] + 1;
+}
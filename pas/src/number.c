@@ -0,0 +1,268 @@
+#include "pas/number.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pow5.inc"
+
+// 19 decimal digits always fit in 64 bits.
+#define NUMBER_MAX_DIGITS 19
+
+static const double kPow10[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+static const char* NumberDigits(const char* p,
+                                const char* end,
+                                bool fraction,
+                                uint64_t* mantissa,
+                                int* digits,
+                                int64_t* exponent,
+                                bool* truncated);
+static bool NumberEiselLemire(uint64_t mantissa,
+                              int64_t exponent,
+                              double* value);
+static bool NumberSlow(const char* text, uint64_t length, double* value);
+static uint64_t NumberLoad8(const char* p);
+static bool NumberIsEightDigits(uint64_t chunk);
+static uint32_t NumberParseEight(uint64_t chunk);
+static bool IsDigit(char c);
+
+bool PasNumberParseInt(const char* text, uint64_t length, uint64_t* value) {
+  const char* p = text;
+  const char* end = text + length;
+  if (p == end) {
+    return false;
+  }
+  while (end - p > 1 && *p == '0') {
+    p++;
+  }
+  uint64_t result = 0;
+  // Two 8-digit steps stay below 10^16; the rest need overflow checks.
+  for (int i = 0; i < 2 && end - p >= 8; ++i) {
+    uint64_t chunk = NumberLoad8(p);
+    if (!NumberIsEightDigits(chunk)) {
+      break;
+    }
+    result = result * 100000000 + NumberParseEight(chunk);
+    p += 8;
+  }
+  for (; p < end; ++p) {
+    if (!IsDigit(*p) || __builtin_mul_overflow(result, 10, &result) ||
+        __builtin_add_overflow(result, (uint64_t)(*p - '0'), &result)) {
+      return false;
+    }
+  }
+  *value = result;
+  return true;
+}
+
+bool PasNumberParseReal(const char* text, uint64_t length, double* value) {
+  const char* p = text;
+  const char* end = text + length;
+  if (p == end || !IsDigit(*p)) {
+    return false;
+  }
+  uint64_t mantissa = 0;
+  int digits = 0;
+  int64_t exponent = 0;
+  bool truncated = false;
+  p = NumberDigits(p, end, false, &mantissa, &digits, &exponent, &truncated);
+  if (p < end && *p == '.') {
+    p = NumberDigits(p + 1, end, true, &mantissa, &digits, &exponent,
+                     &truncated);
+  }
+  if (p < end && (*p | 0x20) == 'e') {
+    p++;
+    bool negative = p < end && *p == '-';
+    if (p < end && (*p == '-' || *p == '+')) {
+      p++;
+    }
+    if (p == end || !IsDigit(*p)) {
+      return false;
+    }
+    int64_t power = 0;
+    for (; p < end && IsDigit(*p); ++p) {
+      // Anything this large is zero or infinity already.
+      if (power < 100000) {
+        power = power * 10 + (*p - '0');
+      }
+    }
+    exponent += negative ? -power : power;
+  }
+  if (p != end) {
+    return false;
+  }
+  if (mantissa == 0) {
+    *value = 0.0;
+    return true;
+  }
+  // Clinger's fast path: both operands are exact doubles, so one IEEE
+  // operation rounds correctly.
+  if (!truncated && mantissa <= (1ull << 53) && exponent >= -22 &&
+      exponent <= 22) {
+    double d = (double)mantissa;
+    *value = exponent < 0 ? d / kPow10[-exponent] : d * kPow10[exponent];
+    return true;
+  }
+  // With digits dropped, the value lies between the mantissa and the next one
+  // up; if both round the same way, so does the value.
+  double low;
+  double high;
+  if (NumberEiselLemire(mantissa, exponent, &low) &&
+      (!truncated || (NumberEiselLemire(mantissa + 1, exponent, &high) &&
+                      low == high))) {
+    *value = low;
+    return true;
+  }
+  return NumberSlow(text, length, value);
+}
+
+bool PasTokenInt(StringView source, const PasToken* token, uint64_t* value) {
+  return PasNumberParseInt(source.data + token->position, token->length,
+                           value);
+}
+
+bool PasTokenReal(StringView source, const PasToken* token, double* value) {
+  return PasNumberParseReal(source.data + token->position, token->length,
+                            value);
+}
+
+// Accumulates up to NUMBER_MAX_DIGITS significant digits into `mantissa`,
+// tracking the decimal exponent of its last digit.
+const char* NumberDigits(const char* p,
+                         const char* end,
+                         bool fraction,
+                         uint64_t* mantissa,
+                         int* digits,
+                         int64_t* exponent,
+                         bool* truncated) {
+  while (p < end && IsDigit(*p)) {
+    if (*digits == 0 && *p == '0') {
+      *exponent -= fraction;
+      p++;
+    } else if (*digits + 8 <= NUMBER_MAX_DIGITS && end - p >= 8 &&
+               NumberIsEightDigits(NumberLoad8(p))) {
+      *mantissa = *mantissa * 100000000 + NumberParseEight(NumberLoad8(p));
+      *digits += 8;
+      *exponent -= fraction ? 8 : 0;
+      p += 8;
+    } else if (*digits < NUMBER_MAX_DIGITS) {
+      *mantissa = *mantissa * 10 + (uint64_t)(*p - '0');
+      *digits += 1;
+      *exponent -= fraction;
+      p++;
+    } else {
+      *exponent += !fraction;
+      *truncated |= *p != '0';
+      p++;
+    }
+  }
+  return p;
+}
+
+// Computes mantissa * 10^exponent from a 128-bit approximation of the power
+// of ten, following Lemire, "Number Parsing at a Gigabyte per Second".
+// Returns false when the approximation cannot decide the rounding or the
+// result is subnormal.
+bool NumberEiselLemire(uint64_t mantissa, int64_t exponent, double* value) {
+  if (exponent < PAS_NUMBER_MIN_POW10_) {
+    *value = 0.0;
+    return true;
+  }
+  if (exponent > PAS_NUMBER_MAX_POW10_) {
+    *value = __builtin_inf();
+    return true;
+  }
+  const uint64_t* pow5 = kPow5[exponent - PAS_NUMBER_MIN_POW10_];
+  // floor(log2(10^exponent)) + 1023 + 63.
+  int64_t binary = (((152170 + 65536) * exponent) >> 16) + 1024 + 63;
+  int shift = __builtin_clzll(mantissa);
+  mantissa <<= shift;
+  unsigned __int128 product = (unsigned __int128)mantissa * pow5[0];
+  uint64_t upper = (uint64_t)(product >> 64);
+  uint64_t lower = (uint64_t)product;
+  if ((upper & 0x1FF) == 0x1FF && lower + mantissa < lower) {
+    unsigned __int128 low_product = (unsigned __int128)mantissa * pow5[1];
+    uint64_t middle = lower + (uint64_t)(low_product >> 64);
+    if (middle < lower) {
+      upper++;
+    }
+    if (middle + 1 == 0 && (upper & 0x1FF) == 0x1FF &&
+        (uint64_t)low_product + mantissa < (uint64_t)low_product) {
+      return false;
+    }
+    lower = middle;
+  }
+  uint64_t upper_bit = upper >> 63;
+  uint64_t bits = upper >> (upper_bit + 9);
+  shift += (int)(1 ^ upper_bit);
+  // Exactly halfway between two doubles: only the full value can tell.
+  if (lower == 0 && (upper & 0x1FF) == 0 && (bits & 3) == 1) {
+    return false;
+  }
+  bits += bits & 1;
+  bits >>= 1;
+  if (bits >= (1ull << 53)) {
+    bits = 1ull << 52;
+    shift--;
+  }
+  bits &= ~(1ull << 52);
+  int64_t biased = binary - shift;
+  if (biased < 1 || biased > 2046) {
+    return false;
+  }
+  bits |= (uint64_t)biased << 52;
+  memcpy(value, &bits, sizeof(*value));
+  return true;
+}
+
+// strtod needs a terminated copy, since tokens point into the source. It
+// assumes the C locale's decimal point.
+bool NumberSlow(const char* text, uint64_t length, double* value) {
+  char buffer[64];
+  char* copy = length < sizeof(buffer) ? buffer : malloc(length + 1);
+  if (copy == NULL) {
+    return false;
+  }
+  memcpy(copy, text, length);
+  copy[length] = '\0';
+  *value = strtod(copy, NULL);
+  if (copy != buffer) {
+    free(copy);
+  }
+  return true;
+}
+
+uint64_t NumberLoad8(const char* p) {
+  uint64_t chunk;
+  memcpy(&chunk, p, sizeof(chunk));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  chunk = __builtin_bswap64(chunk);
+#endif
+  return chunk;
+}
+
+bool NumberIsEightDigits(uint64_t chunk) {
+  return ((chunk & 0xF0F0F0F0F0F0F0F0ull) |
+          (((chunk + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) >> 4)) ==
+         0x3333333333333333ull;
+}
+
+// Converts eight ASCII digits, first digit in the low byte, with three
+// multiplies instead of eight.
+uint32_t NumberParseEight(uint64_t chunk) {
+  chunk -= 0x3030303030303030ull;
+  chunk = chunk * 10 + (chunk >> 8);
+  chunk = ((chunk & 0x000000FF000000FFull) * (100 + (1000000ull << 32)) +
+           ((chunk >> 16) & 0x000000FF000000FFull) * (1 + (10000ull << 32))) >>
+          32;
+  return (uint32_t)chunk;
+}
+
+bool IsDigit(char c) {
+  return c >= '0' && c <= '9';
+}
@@ -0,0 +1,1166 @@
+#include "pas/parse.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+
+const char* const kPasNodeKindNames[] = {
+#define X(x) #x,
+    PAS_NODE_KIND_VARIANTS_
+#undef X
+};
+
+// Bounds the recursion of nested statements, expressions and types.
+#define PARSER_MAX_DEPTH 1000
+
+// Each Parse function pushes the index of the node it built onto `stack`. A
+// node's children are the entries its function's callees pushed, which
+// ParserClose moves to the tree in one piece.
+typedef struct {
+  const PasTokenStream* tokens;
+  StringView text;
+  uint64_t count;
+  // The current significant token, or `count` at the end.
+  uint64_t index;
+  // The end of the last token consumed.
+  uint64_t end;
+  PasAst* ast;
+  VEC_TYPE(uint32_t) stack;
+  PasParseError* error;
+  uint32_t depth;
+} Parser;
+
+static bool ParseProgram(Parser* parser);
+static bool ParseUnit(Parser* parser);
+static bool ParseUses(Parser* parser);
+static bool ParseDeclarations(Parser* parser, bool headings);
+static bool ParseBlock(Parser* parser);
+static bool ParseLabelSection(Parser* parser);
+static bool ParseConstSection(Parser* parser);
+static bool ParseTypeSection(Parser* parser);
+static bool ParseVarSection(Parser* parser);
+static bool ParseVarDecl(Parser* parser);
+static bool ParseRoutine(Parser* parser, bool heading);
+static bool ParseParams(Parser* parser);
+static bool ParseNames(Parser* parser);
+static bool ParseType(Parser* parser);
+static bool ParseStructuredType(Parser* parser, PasTokenType packed);
+static bool ParseFields(Parser* parser, uint32_t token, PasTokenType packed);
+static bool ParseVariantPart(Parser* parser);
+static bool ParseLabels(Parser* parser);
+static bool ParseCompound(Parser* parser);
+static bool ParseStatements(Parser* parser);
+static bool ParseStatement(Parser* parser);
+static bool ParseStatementKind(Parser* parser);
+static bool ParseCase(Parser* parser);
+static bool ParseExpression(Parser* parser);
+static bool ParseSimpleExpression(Parser* parser);
+static bool ParseTerm(Parser* parser);
+static bool ParseFactor(Parser* parser);
+static bool ParseFactorKind(Parser* parser);
+static bool ParseString(Parser* parser);
+static bool ParseCharCode(Parser* parser);
+static bool ParseSet(Parser* parser);
+static bool ParseDesignator(Parser* parser);
+static bool ParseArgument(Parser* parser);
+
+static bool ParserClose(Parser* parser,
+                        PasNodeKind kind,
+                        PasTokenType op,
+                        uint32_t token,
+                        uint64_t base);
+static bool ParserLeaf(Parser* parser, PasNodeKind kind, uint32_t token);
+static bool ParserEnter(Parser* parser);
+static bool ParserFail(Parser* parser,
+                       const char* message,
+                       PasTokenType expected);
+static bool ParserAtEnd(const Parser* parser);
+static PasTokenType ParserPeek(const Parser* parser);
+static PasTokenType ParserPeekNext(const Parser* parser);
+static uint64_t ParserSkipTrivia(const Parser* parser, uint64_t index);
+static uint32_t ParserAdvance(Parser* parser);
+static bool ParserAccept(Parser* parser, PasTokenType type);
+static bool ParserExpect(Parser* parser, PasTokenType type, uint32_t* token);
+static bool ParserExpectName(Parser* parser, uint32_t* token);
+static bool ParserIsName(const Parser* parser);
+static bool ParserIsDirective(const Parser* parser);
+static bool ParserTextIs(const Parser* parser, const char* word);
+static bool ParserIsHash(const Parser* parser);
+static uint64_t ParserPosition(const Parser* parser, uint64_t index);
+
+bool PasParse(const PasTokenStream* tokens,
+              StringView text,
+              const VecAllocator* allocator,
+              PasAst* ast,
+              PasParseError* error) {
+  *ast = (PasAst){0};
+  VEC_SET_ALLOCATOR(&ast->nodes, allocator);
+  VEC_SET_ALLOCATOR(&ast->children, allocator);
+  *error = (PasParseError){0};
+  Parser parser = {
+      .tokens = tokens,
+      .text = text,
+      .count = PasTokenStreamSize(tokens),
+      .ast = ast,
+      .error = error,
+  };
+  VEC_SET_ALLOCATOR(&parser.stack, allocator);
+  parser.index = ParserSkipTrivia(&parser, 0);
+  bool ok;
+  if (parser.count >= PAS_NO_TOKEN) {
+    ok = ParserFail(&parser, "too many tokens", kPasTokenTypeZero);
+  } else if (ParserPeek(&parser) == kPasTokenTypeUnit) {
+    ok = ParseUnit(&parser);
+  } else {
+    ok = ParseProgram(&parser);
+  }
+  if (ok) {
+    ast->root = parser.stack.data[0];
+  } else {
+    PasAstFree(ast);
+  }
+  VEC_FREE(&parser.stack);
+  return ok;
+}
+
+void PasAstFree(PasAst* ast) {
+  VEC_FREE(&ast->nodes);
+  VEC_FREE(&ast->children);
+  ast->root = 0;
+}
+
+bool ParseProgram(Parser* parser) {
+  uint64_t base = parser->stack.size;
+  uint32_t name = PAS_NO_TOKEN;
+  if (ParserAccept(parser, kPasTokenTypeProgram)) {
+    if (!ParserExpectName(parser, &name)) {
+      return false;
+    }
+    // Program parameters name files and have no meaning of their own.
+    if (ParserAccept(parser, kPasTokenTypeLParen)) {
+      do {
+        if (!ParserExpectName(parser, NULL)) {
+          return false;
+        }
+      } while (ParserAccept(parser, kPasTokenTypeComma));
+      if (!ParserExpect(parser, kPasTokenTypeRParen, NULL)) {
+        return false;
+      }
+    }
+    if (!ParserExpect(parser, kPasTokenTypeSemi, NULL)) {
+      return false;
+    }
+  }
+  if (ParserPeek(parser) == kPasTokenTypeUses && !ParseUses(parser)) {
+    return false;
+  }
+  return ParseBlock(parser) &&
+         ParserExpect(parser, kPasTokenTypeDot, NULL) &&
+         ParserClose(parser, kPasNodeProgram, kPasTokenTypeZero, name, base);
+}
+
+bool ParseUnit(Parser* parser) {
+  uint64_t base = parser->stack.size;
+  uint32_t name;
+  ParserAdvance(parser);
+  if (!ParserExpectName(parser, &name) ||
+      !ParserExpect(parser, kPasTokenTypeSemi, NULL)) {
+    return false;
+  }
+  uint64_t part = parser->stack.size;
+  uint32_t token = PAS_NO_TOKEN;
+  if (!ParserExpect(parser, kPasTokenTypeInterface, &token) ||
+      (ParserPeek(parser) == kPasTokenTypeUses && !ParseUses(parser)) ||
+      !ParseDeclarations(parser, true) ||
+      !ParserClose(parser, kPasNodeInterface, kPasTokenTypeZero, token,
+                   part)) {
+    return false;
+  }
+  part = parser->stack.size;
+  if (!ParserExpect(parser, kPasTokenTypeImplementation, &token) ||
+      (ParserPeek(parser) == kPasTokenTypeUses && !ParseUses(parser)) ||
+      !ParseDeclarations(parser, false)) {
+    return false;
+  }
+  if (ParserPeek(parser) == kPasTokenTypeBegin) {
+    if (!ParseCompound(parser)) {
+      return false;
+    }
+  } else if (!ParserExpect(parser, kPasTokenTypeEnd, NULL)) {
+    return false;
+  }
+  return ParserClose(parser, kPasNodeImplementation, kPasTokenTypeZero, token,
+                     part) &&
+         ParserExpect(parser, kPasTokenTypeDot, NULL) &&
+         ParserClose(parser, kPasNodeUnit, kPasTokenTypeZero, name, base);
+}
+
+bool ParseUses(Parser* parser) {
+  uint64_t base = parser->stack.size;
+  uint32_t token = ParserAdvance(parser);
+  do {
+    uint32_t name = PAS_NO_TOKEN;
+    if (!ParserExpectName(parser, &name) ||
+        !ParserLeaf(parser, kPasNodeName, name)) {
+      return false;
+    }
+    if (ParserAccept(parser, kPasTokenTypeIn) &&
+        !ParserExpect(parser, kPasTokenTypeStringLiteral, NULL)) {
+      return false;
+    }
+  } while (ParserAccept(parser, kPasTokenTypeComma));
+  return ParserExpect(parser, kPasTokenTypeSemi, NULL) &&
+         ParserClose(parser, kPasNodeUses, kPasTokenTypeZero, token, base);
+}
+
+// Parses sections and routines until something else comes up. `headings`
+// parses routine headings only, as in a unit interface.
+bool ParseDeclarations(Parser* parser, bool headings) {
+  while (true) {
+    bool ok;
+    switch (ParserPeek(parser)) {
+      case kPasTokenTypeLabel:
+        ok = ParseLabelSection(parser);
+        break;
+      case kPasTokenTypeConst:
+        ok = ParseConstSection(parser);
+        break;
+      case kPasTokenTypeType:
+        ok = ParseTypeSection(parser);
+        break;
+      case kPasTokenTypeVar:
+        ok = ParseVarSection(parser);
+        break;
+      case kPasTokenTypeProcedure:
+      case kPasTokenTypeFunction:
+        ok = ParseRoutine(parser, headings);
+        break;
+      default:
+        return true;
+    }
+    if (!ok) {
+      return false;
+    }
+  }
+}
+
+bool ParseBlock(Parser* parser) {
+  uint64_t base = parser->stack.size;
+  return ParseDeclarations(parser, false) && ParseCompound(parser) &&
+         ParserClose(parser, kPasNodeBlock, kPasTokenTypeZero, PAS_NO_TOKEN,
+                     base);
+}
+
+bool ParseLabelSection(Parser* parser) {
+  uint64_t base = parser->stack.size;
+  uint32_t token = ParserAdvance(parser);
+  do {
+    bool ok;
+    if (ParserPeek(parser) == kPasTokenTypeNumInt) {
+      ok = ParserLeaf(parser, kPasNodeInt, ParserAdvance(parser));
+    } else {
+      uint32_t name;
+      ok = ParserExpectName(parser, &name) &&
+           ParserLeaf(parser, kPasNodeName, name);
+    }
+    if (!ok) {
+      return false;
+    }
+  } while (ParserAccept(parser, kPasTokenTypeComma));
+  return ParserExpect(parser, kPasTokenTypeSemi, NULL) &&
+         ParserClose(parser, kPasNodeLabelSection, kPasTokenTypeZero, token,
+                     base);
+}
+
+bool ParseConstSection(Parser* parser) {
+  uint64_t base = parser->stack.size;
+  uint32_t token = ParserAdvance(parser);
+  do {
+    uint64_t decl = parser->stack.size;
+    uint32_t name;
+    if (!ParserExpectName(parser, &name) ||
+        (ParserAccept(parser, kPasTokenTypeColon) && !ParseType(parser)) ||
+        !ParserExpect(parser, kPasTokenTypeEqual, NULL) ||
+        !ParseExpression(parser) ||
+        !ParserExpect(parser, kPasTokenTypeSemi, NULL) ||
+        !ParserClose(parser, kPasNodeConstDecl, kPasTokenTypeZero, name,
+                     decl)) {
+      return false;
+    }
+  } while (ParserPeek(parser) == kPasTokenTypeIdent);
+  return ParserClose(parser, kPasNodeConstSection, kPasTokenTypeZero, token,
+                     base);
+}
+
+bool ParseTypeSection(Parser* parser) {
+  uint64_t base = parser->stack.size;
+  uint32_t token = ParserAdvance(parser);
+  do {
+    uint64_t decl = parser->stack.size;
+    uint32_t name;
+    if (!ParserExpectName(parser, &name) ||
+        !ParserExpect(parser, kPasTokenTypeEqual, NULL) ||
+        !ParseType(parser) ||
+        !ParserExpect(parser, kPasTokenTypeSemi, NULL) ||
+        !ParserClose(parser, kPasNodeTypeDecl, kPasTokenTypeZero, name,
+                     decl)) {
+      return false;
+    }
+  } while (ParserPeek(parser) == kPasTokenTypeIdent);
+  return ParserClose(parser, kPasNodeTypeSection, kPasTokenTypeZero, token,
+                     base);
+}
+
+bool ParseVarSection(Parser* parser) {
+  uint64_t base = parser->stack.size;
+  uint32_t token = ParserAdvance(parser);
+  do {
+    if (!ParseVarDecl(parser) ||
+        !ParserExpect(parser, kPasTokenTypeSemi, NULL)) {
+      return false;
+    }
+  } while (ParserPeek(parser) == kPasTokenTypeIdent);
+  return ParserClose(parser, kPasNodeVarSection, kPasTokenTypeZero, token,
+                     base);
+}
+
+bool ParseVarDecl(Parser* parser) {
+  uint64_t base = parser->stack.size;
+  return ParseNames(parser) &&
+         ParserExpect(parser, kPasTokenTypeColon, NULL) && ParseType(parser) &&
+         ParserClose(parser, kPasNodeVarDecl, kPasTokenTypeZero, PAS_NO_TOKEN,
+                     base);
+}
+
+bool ParseRoutine(Parser* parser, bool heading) {
+  uint64_t base = parser->stack.size;
+  bool function = ParserPeek(parser) == kPasTokenTypeFunction;
+  ParserAdvance(parser);
+  uint32_t name;
+  if (!ParserExpectName(parser, &name) ||
+      (ParserPeek(parser) == kPasTokenTypeLParen && !ParseParams(parser)) ||
+      (function && ParserAccept(parser, kPasTokenTypeColon) &&
+       !ParseType(parser)) ||
+      !ParserExpect(parser, kPasTokenTypeSemi, NULL)) {
+    return false;
+  }
+  // Directives such as forward or external end at the next ';'.
+  bool body = !heading;
+  while (ParserIsDirective(parser)) {
+    if (ParserTextIs(parser, "forward") || ParserTextIs(parser, "external")) {
+      body = false;
+    }
+    if (!ParserLeaf(parser, kPasNodeDirective, ParserAdvance(parser))) {
+      return false;
+    }
+    while (!ParserAtEnd(parser) && ParserPeek(parser) != kPasTokenTypeSemi) {
+      ParserAdvance(parser);
+    }
+    if (!ParserExpect(parser, kPasTokenTypeSemi, NULL)) {
+      return false;
+    }
+  }
+  if (body && (!ParseBlock(parser) ||
+               !ParserExpect(parser, kPasTokenTypeSemi, NULL))) {
+    return false;
+  }
+  return ParserClose(parser, function ? kPasNodeFunction : kPasNodeProcedure,
+                     kPasTokenTypeZero, name, base);
+}
+
+bool ParseParams(Parser* parser) {
+  uint64_t base = parser->stack.size;
+  uint32_t token = ParserAdvance(parser);
+  do {
+    uint64_t group = parser->stack.size;
+    PasTokenType mode = ParserPeek(parser);
+    if (mode == kPasTokenTypeVar || mode == kPasTokenTypeConst) {
+      ParserAdvance(parser);
+    } else {
+      mode = kPasTokenTypeZero;
+    }
+    if (!ParseNames(parser) ||
+        (ParserAccept(parser, kPasTokenTypeColon) && !ParseType(parser)) ||
+        !ParserClose(parser, kPasNodeParamGroup, mode, PAS_NO_TOKEN, group)) {
+      return false;
+    }
+  } while (ParserAccept(parser, kPasTokenTypeSemi));
+  return ParserExpect(parser, kPasTokenTypeRParen, NULL) &&
+         ParserClose(parser, kPasNodeParams, kPasTokenTypeZero, token, base);
+}
+
+bool ParseNames(Parser* parser) {
+  do {
+    uint32_t name;
+    if (!ParserExpectName(parser, &name) ||
+        !ParserLeaf(parser, kPasNodeName, name)) {
+      return false;
+    }
+  } while (ParserAccept(parser, kPasTokenTypeComma));
+  return true;
+}
+
+bool ParseType(Parser* parser) {
+  if (!ParserEnter(parser)) {
+    return false;
+  }
+  uint64_t base = parser->stack.size;
+  uint32_t token = parser->index;
+  bool ok;
+  switch (ParserPeek(parser)) {
+    case kPasTokenTypeString:
+      ParserAdvance(parser);
+      ok = !ParserAccept(parser, kPasTokenTypeLBracket) ||
+           (ParseExpression(parser) &&
+            ParserExpect(parser, kPasTokenTypeRBracket, NULL));
+      ok = ok && ParserClose(parser, kPasNodeStringType, kPasTokenTypeZero,
+                             token, base);
+      break;
+    case kPasTokenTypePointer: {
+      ParserAdvance(parser);
+      uint32_t name;
+      ok = ParserExpectName(parser, &name) &&
+           ParserLeaf(parser, kPasNodeTypeName, name) &&
+           ParserClose(parser, kPasNodePointerType, kPasTokenTypeZero, token,
+                       base);
+    } break;
+    case kPasTokenTypePacked:
+      ParserAdvance(parser);
+      ok = ParseStructuredType(parser, kPasTokenTypePacked);
+      break;
+    case kPasTokenTypeArray:
+    case kPasTokenTypeRecord:
+    case kPasTokenTypeSet:
+    case kPasTokenTypeFile:
+      ok = ParseStructuredType(parser, kPasTokenTypeZero);
+      break;
+    case kPasTokenTypeLParen:
+      ParserAdvance(parser);
+      ok = ParseNames(parser) &&
+           ParserExpect(parser, kPasTokenTypeRParen, NULL) &&
+           ParserClose(parser, kPasNodeEnumType, kPasTokenTypeZero, token,
+                       base);
+      break;
+    default:
+      if (ParserIsName(parser) &&
+          ParserPeekNext(parser) != kPasTokenTypeDotDot) {
+        ok = ParserLeaf(parser, kPasNodeTypeName, ParserAdvance(parser));
+        break;
+      }
+      ok = ParseExpression(parser) &&
+           ParserExpect(parser, kPasTokenTypeDotDot, &token) &&
+           ParseExpression(parser) &&
+           ParserClose(parser, kPasNodeSubrangeType, kPasTokenTypeZero, token,
+                       base);
+      break;
+  }
+  parser->depth--;
+  return ok;
+}
+
+bool ParseStructuredType(Parser* parser, PasTokenType packed) {
+  uint64_t base = parser->stack.size;
+  uint32_t token = parser->index;
+  switch (ParserPeek(parser)) {
+    case kPasTokenTypeArray:
+      ParserAdvance(parser);
+      // Without bounds this is an open array parameter.
+      if (ParserAccept(parser, kPasTokenTypeLBracket)) {
+        do {
+          if (!ParseType(parser)) {
+            return false;
+          }
+        } while (ParserAccept(parser, kPasTokenTypeComma));
+        if (!ParserExpect(parser, kPasTokenTypeRBracket, NULL)) {
+          return false;
+        }
+      }
+      return ParserExpect(parser, kPasTokenTypeOf, NULL) &&
+             ParseType(parser) &&
+             ParserClose(parser, kPasNodeArrayType, packed, token, base);
+    case kPasTokenTypeRecord:
+      ParserAdvance(parser);
+      return ParseFields(parser, token, packed) &&
+             ParserExpect(parser, kPasTokenTypeEnd, NULL);
+    case kPasTokenTypeSet:
+      ParserAdvance(parser);
+      return ParserExpect(parser, kPasTokenTypeOf, NULL) &&
+             ParseType(parser) &&
+             ParserClose(parser, kPasNodeSetType, packed, token, base);
+    case kPasTokenTypeFile:
+      ParserAdvance(parser);
+      return (!ParserAccept(parser, kPasTokenTypeOf) || ParseType(parser)) &&
+             ParserClose(parser, kPasNodeFileType, packed, token, base);
+    default:
+      return ParserFail(parser, "expected a structured type",
+                        kPasTokenTypeZero);
+  }
+}
+
+// Parses a field list into a RecordType: fields, then an optional variant
+// part. Callers consume the closing token.
+bool ParseFields(Parser* parser, uint32_t token, PasTokenType packed) {
+  uint64_t base = parser->stack.size;
+  while (ParserPeek(parser) == kPasTokenTypeIdent) {
+    if (!ParseVarDecl(parser)) {
+      return false;
+    }
+    if (!ParserAccept(parser, kPasTokenTypeSemi)) {
+      break;
+    }
+  }
+  if (ParserPeek(parser) == kPasTokenTypeCase && !ParseVariantPart(parser)) {
+    return false;
+  }
+  return ParserClose(parser, kPasNodeRecordType, packed, token, base);
+}
+
+bool ParseVariantPart(Parser* parser) {
+  uint64_t base = parser->stack.size;
+  ParserAdvance(parser);
+  uint32_t tag = PAS_NO_TOKEN;
+  if (ParserPeek(parser) == kPasTokenTypeIdent &&
+      ParserPeekNext(parser) == kPasTokenTypeColon) {
+    tag = ParserAdvance(parser);
+    ParserAdvance(parser);
+  }
+  if (!ParseType(parser) || !ParserExpect(parser, kPasTokenTypeOf, NULL)) {
+    return false;
+  }
+  while (!ParserAtEnd(parser) && ParserPeek(parser) != kPasTokenTypeEnd &&
+         ParserPeek(parser) != kPasTokenTypeRParen) {
+    uint64_t arm = parser->stack.size;
+    uint32_t fields = PAS_NO_TOKEN;
+    if (!ParseLabels(parser) ||
+        !ParserExpect(parser, kPasTokenTypeColon, NULL) ||
+        !ParserExpect(parser, kPasTokenTypeLParen, &fields) ||
+        !ParseFields(parser, fields, kPasTokenTypeZero) ||
+        !ParserExpect(parser, kPasTokenTypeRParen, NULL) ||
+        !ParserClose(parser, kPasNodeVariantArm, kPasTokenTypeZero,
+                     PAS_NO_TOKEN, arm)) {
+      return false;
+    }
+    if (!ParserAccept(parser, kPasTokenTypeSemi)) {
+      break;
+    }
+  }
+  return ParserClose(parser, kPasNodeVariantPart, kPasTokenTypeZero, tag,
+                     base);
+}
+
+// Parses case labels: constants and ranges separated by commas.
+bool ParseLabels(Parser* parser) {
+  do {
+    uint64_t base = parser->stack.size;
+    if (!ParseExpression(parser)) {
+      return false;
+    }
+    uint32_t token = parser->index;
+    if (ParserAccept(parser, kPasTokenTypeDotDot) &&
+        (!ParseExpression(parser) ||
+         !ParserClose(parser, kPasNodeRange, kPasTokenTypeZero, token,
+                      base))) {
+      return false;
+    }
+  } while (ParserAccept(parser, kPasTokenTypeComma));
+  return true;
+}
+
+bool ParseCompound(Parser* parser) {
+  uint64_t base = parser->stack.size;
+  uint32_t token = PAS_NO_TOKEN;
+  return ParserExpect(parser, kPasTokenTypeBegin, &token) &&
+         ParseStatements(parser) &&
+         ParserExpect(parser, kPasTokenTypeEnd, NULL) &&
+         ParserClose(parser, kPasNodeCompound, kPasTokenTypeZero, token,
+                     base);
+}
+
+// Parses statements separated by ';' up to an end or until. Empty statements
+// leave no node.
+bool ParseStatements(Parser* parser) {
+  while (true) {
+    while (ParserAccept(parser, kPasTokenTypeSemi)) {
+    }
+    PasTokenType type = ParserPeek(parser);
+    if (ParserAtEnd(parser) || type == kPasTokenTypeEnd ||
+        type == kPasTokenTypeUntil) {
+      return true;
+    }
+    if (!ParseStatement(parser)) {
+      return false;
+    }
+    if (!ParserAccept(parser, kPasTokenTypeSemi)) {
+      return true;
+    }
+  }
+}
+
+bool ParseStatement(Parser* parser) {
+  if (!ParserEnter(parser)) {
+    return false;
+  }
+  bool ok = ParseStatementKind(parser);
+  parser->depth--;
+  return ok;
+}
+
+bool ParseStatementKind(Parser* parser) {
+  uint64_t base = parser->stack.size;
+  uint32_t token = parser->index;
+  switch (ParserPeek(parser)) {
+    case kPasTokenTypeBegin:
+      return ParseCompound(parser);
+    case kPasTokenTypeIf:
+      ParserAdvance(parser);
+      return ParseExpression(parser) &&
+             ParserExpect(parser, kPasTokenTypeThen, NULL) &&
+             ParseStatement(parser) &&
+             (!ParserAccept(parser, kPasTokenTypeElse) ||
+              ParseStatement(parser)) &&
+             ParserClose(parser, kPasNodeIf, kPasTokenTypeZero, token, base);
+    case kPasTokenTypeWhile:
+      ParserAdvance(parser);
+      return ParseExpression(parser) &&
+             ParserExpect(parser, kPasTokenTypeDo, NULL) &&
+             ParseStatement(parser) &&
+             ParserClose(parser, kPasNodeWhile, kPasTokenTypeZero, token,
+                         base);
+    case kPasTokenTypeRepeat:
+      ParserAdvance(parser);
+      return ParseStatements(parser) &&
+             ParserExpect(parser, kPasTokenTypeUntil, NULL) &&
+             ParseExpression(parser) &&
+             ParserClose(parser, kPasNodeRepeat, kPasTokenTypeZero, token,
+                         base);
+    case kPasTokenTypeFor: {
+      ParserAdvance(parser);
+      uint32_t name;
+      if (!ParserExpectName(parser, &name) ||
+          !ParserLeaf(parser, kPasNodeName, name) ||
+          !ParserExpect(parser, kPasTokenTypeAssign, NULL) ||
+          !ParseExpression(parser)) {
+        return false;
+      }
+      PasTokenType direction = ParserPeek(parser);
+      if (direction != kPasTokenTypeTo && direction != kPasTokenTypeDownto) {
+        return ParserFail(parser, "expected to or downto", kPasTokenTypeTo);
+      }
+      ParserAdvance(parser);
+      return ParseExpression(parser) &&
+             ParserExpect(parser, kPasTokenTypeDo, NULL) &&
+             ParseStatement(parser) &&
+             ParserClose(parser, kPasNodeFor, direction, token, base);
+    }
+    case kPasTokenTypeCase:
+      return ParseCase(parser);
+    case kPasTokenTypeWith:
+      ParserAdvance(parser);
+      do {
+        if (!ParseDesignator(parser)) {
+          return false;
+        }
+      } while (ParserAccept(parser, kPasTokenTypeComma));
+      return ParserExpect(parser, kPasTokenTypeDo, NULL) &&
+             ParseStatement(parser) &&
+             ParserClose(parser, kPasNodeWith, kPasTokenTypeZero, token,
+                         base);
+    case kPasTokenTypeGoto: {
+      ParserAdvance(parser);
+      uint32_t label = parser->index;
+      if (ParserPeek(parser) == kPasTokenTypeNumInt) {
+        ParserAdvance(parser);
+      } else if (!ParserExpectName(parser, NULL)) {
+        return false;
+      }
+      return ParserLeaf(parser, kPasNodeGoto, label);
+    }
+    case kPasTokenTypeSemi:
+    case kPasTokenTypeEnd:
+    case kPasTokenTypeElse:
+    case kPasTokenTypeUntil:
+      return ParserLeaf(parser, kPasNodeEmpty, PAS_NO_TOKEN);
+    default:
+      break;
+  }
+  if ((ParserPeek(parser) == kPasTokenTypeNumInt || ParserIsName(parser)) &&
+      ParserPeekNext(parser) == kPasTokenTypeColon) {
+    ParserAdvance(parser);
+    ParserAdvance(parser);
+    return ParseStatement(parser) &&
+           ParserClose(parser, kPasNodeLabeled, kPasTokenTypeZero, token,
+                       base);
+  }
+  if (!ParserIsName(parser)) {
+    return ParserFail(parser, "expected a statement", kPasTokenTypeZero);
+  }
+  if (!ParseDesignator(parser)) {
+    return false;
+  }
+  uint32_t assign = parser->index;
+  if (ParserAccept(parser, kPasTokenTypeAssign)) {
+    return ParseExpression(parser) &&
+           ParserClose(parser, kPasNodeAssign, kPasTokenTypeZero, assign,
+                       base);
+  }
+  return true;
+}
+
+bool ParseCase(Parser* parser) {
+  uint64_t base = parser->stack.size;
+  uint32_t token = ParserAdvance(parser);
+  if (!ParseExpression(parser) ||
+      !ParserExpect(parser, kPasTokenTypeOf, NULL)) {
+    return false;
+  }
+  while (true) {
+    while (ParserAccept(parser, kPasTokenTypeSemi)) {
+    }
+    PasTokenType type = ParserPeek(parser);
+    if (ParserAtEnd(parser) || type == kPasTokenTypeEnd ||
+        type == kPasTokenTypeElse) {
+      break;
+    }
+    uint64_t arm = parser->stack.size;
+    if (!ParseLabels(parser) ||
+        !ParserExpect(parser, kPasTokenTypeColon, NULL) ||
+        !ParseStatement(parser) ||
+        !ParserClose(parser, kPasNodeCaseArm, kPasTokenTypeZero, PAS_NO_TOKEN,
+                     arm)) {
+      return false;
+    }
+    if (!ParserAccept(parser, kPasTokenTypeSemi)) {
+      break;
+    }
+  }
+  if (ParserPeek(parser) == kPasTokenTypeElse) {
+    uint64_t other = parser->stack.size;
+    uint32_t other_token = ParserAdvance(parser);
+    if (!ParseStatements(parser) ||
+        !ParserClose(parser, kPasNodeCaseElse, kPasTokenTypeZero, other_token,
+                     other)) {
+      return false;
+    }
+  }
+  return ParserExpect(parser, kPasTokenTypeEnd, NULL) &&
+         ParserClose(parser, kPasNodeCase, kPasTokenTypeZero, token, base);
+}
+
+bool ParseExpression(Parser* parser) {
+  if (!ParserEnter(parser)) {
+    return false;
+  }
+  uint64_t base = parser->stack.size;
+  bool ok = ParseSimpleExpression(parser);
+  PasTokenType op = ParserPeek(parser);
+  if (ok && (op == kPasTokenTypeEqual || op == kPasTokenTypeNotEqual ||
+             op == kPasTokenTypeLt || op == kPasTokenTypeLe ||
+             op == kPasTokenTypeGt || op == kPasTokenTypeGe ||
+             op == kPasTokenTypeIn)) {
+    uint32_t token = ParserAdvance(parser);
+    ok = ParseSimpleExpression(parser) &&
+         ParserClose(parser, kPasNodeBinary, op, token, base);
+  }
+  parser->depth--;
+  return ok;
+}
+
+bool ParseSimpleExpression(Parser* parser) {
+  uint64_t base = parser->stack.size;
+  PasTokenType op = ParserPeek(parser);
+  if (op == kPasTokenTypePlus || op == kPasTokenTypeMinus) {
+    uint32_t token = ParserAdvance(parser);
+    if (!ParseTerm(parser) ||
+        !ParserClose(parser, kPasNodeUnary, op, token, base)) {
+      return false;
+    }
+  } else if (!ParseTerm(parser)) {
+    return false;
+  }
+  while ((op = ParserPeek(parser)) == kPasTokenTypePlus ||
+         op == kPasTokenTypeMinus || op == kPasTokenTypeOr) {
+    uint32_t token = ParserAdvance(parser);
+    if (!ParseTerm(parser) ||
+        !ParserClose(parser, kPasNodeBinary, op, token, base)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool ParseTerm(Parser* parser) {
+  uint64_t base = parser->stack.size;
+  if (!ParseFactor(parser)) {
+    return false;
+  }
+  PasTokenType op;
+  while ((op = ParserPeek(parser)) == kPasTokenTypeStar ||
+         op == kPasTokenTypeSlash || op == kPasTokenTypeDiv ||
+         op == kPasTokenTypeMod || op == kPasTokenTypeAnd) {
+    uint32_t token = ParserAdvance(parser);
+    if (!ParseFactor(parser) ||
+        !ParserClose(parser, kPasNodeBinary, op, token, base)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool ParseFactor(Parser* parser) {
+  if (!ParserEnter(parser)) {
+    return false;
+  }
+  bool ok = ParseFactorKind(parser);
+  parser->depth--;
+  return ok;
+}
+
+bool ParseFactorKind(Parser* parser) {
+  uint64_t base = parser->stack.size;
+  PasTokenType type = ParserPeek(parser);
+  if (ParserAtEnd(parser)) {
+    return ParserFail(parser, "expected an expression", kPasTokenTypeZero);
+  }
+  switch (type) {
+    case kPasTokenTypeNot:
+    case kPasTokenTypeAt: {
+      uint32_t token = ParserAdvance(parser);
+      return ParseFactor(parser) &&
+             ParserClose(parser, kPasNodeUnary, type, token, base);
+    }
+    case kPasTokenTypeNumInt:
+      return ParserLeaf(parser, kPasNodeInt, ParserAdvance(parser));
+    case kPasTokenTypeNumReal:
+      return ParserLeaf(parser, kPasNodeReal, ParserAdvance(parser));
+    case kPasTokenTypeStringLiteral:
+    case kPasTokenTypePointer:
+      return ParseString(parser);
+    case kPasTokenTypeNil:
+      return ParserLeaf(parser, kPasNodeNil, ParserAdvance(parser));
+    case kPasTokenTypeTrue:
+    case kPasTokenTypeFalse:
+      return ParserLeaf(parser, kPasNodeBool, ParserAdvance(parser));
+    case kPasTokenTypeLParen:
+      ParserAdvance(parser);
+      return ParseExpression(parser) &&
+             ParserExpect(parser, kPasTokenTypeRParen, NULL);
+    case kPasTokenTypeLBracket:
+    case kPasTokenTypeLBracket2:
+      return ParseSet(parser);
+    default:
+      if (ParserIsHash(parser)) {
+        return ParseString(parser);
+      }
+      if (ParserIsName(parser)) {
+        return ParseDesignator(parser);
+      }
+      return ParserFail(parser, "expected an expression", kPasTokenTypeZero);
+  }
+}
+
+// Parses literals and character codes written without space between them,
+// as in 'line'#13#10. A single piece stands alone; several become the
+// children of a String.
+bool ParseString(Parser* parser) {
+  uint64_t base = parser->stack.size;
+  uint32_t token = parser->index;
+  do {
+    bool ok = ParserPeek(parser) == kPasTokenTypeStringLiteral
+                  ? ParserLeaf(parser, kPasNodeString, ParserAdvance(parser))
+                  : ParseCharCode(parser);
+    if (!ok) {
+      return false;
+    }
+  } while (!ParserAtEnd(parser) &&
+           ParserPosition(parser, parser->index) == parser->end &&
+           (ParserPeek(parser) == kPasTokenTypeStringLiteral ||
+            ParserPeek(parser) == kPasTokenTypePointer ||
+            ParserIsHash(parser)));
+  return parser->stack.size - base == 1 ||
+         ParserClose(parser, kPasNodeString, kPasTokenTypeZero, token, base);
+}
+
+// Parses ^C or #N, which must be written without space.
+bool ParseCharCode(Parser* parser) {
+  uint32_t token = ParserAdvance(parser);
+  bool caret = PasTokenStreamType(parser->tokens, token) ==
+               kPasTokenTypePointer;
+  if (ParserAtEnd(parser) ||
+      ParserPosition(parser, parser->index) != parser->end ||
+      (caret ? PasTokenStreamLength(parser->tokens, parser->index) != 1
+             : ParserPeek(parser) != kPasTokenTypeNumInt)) {
+    return ParserFail(parser, "expected a character code", kPasTokenTypeZero);
+  }
+  ParserAdvance(parser);
+  return ParserLeaf(parser, kPasNodeCharCode, token);
+}
+
+bool ParseSet(Parser* parser) {
+  uint64_t base = parser->stack.size;
+  PasTokenType close = ParserPeek(parser) == kPasTokenTypeLBracket
+                           ? kPasTokenTypeRBracket
+                           : kPasTokenTypeRBracket2;
+  uint32_t token = ParserAdvance(parser);
+  if (ParserPeek(parser) != close && !ParseLabels(parser)) {
+    return false;
+  }
+  return ParserExpect(parser, close, NULL) &&
+         ParserClose(parser, kPasNodeSet, kPasTokenTypeZero, token, base);
+}
+
+// Parses a name with any calls, indexing, field selections and
+// dereferences after it.
+bool ParseDesignator(Parser* parser) {
+  uint64_t base = parser->stack.size;
+  uint32_t name;
+  if (!ParserExpectName(parser, &name) ||
+      !ParserLeaf(parser, kPasNodeName, name)) {
+    return false;
+  }
+  while (true) {
+    uint32_t token = parser->index;
+    PasTokenType type = ParserPeek(parser);
+    bool ok;
+    if (type == kPasTokenTypeLParen) {
+      ParserAdvance(parser);
+      if (ParserPeek(parser) != kPasTokenTypeRParen) {
+        do {
+          if (!ParseArgument(parser)) {
+            return false;
+          }
+        } while (ParserAccept(parser, kPasTokenTypeComma));
+      }
+      ok = ParserExpect(parser, kPasTokenTypeRParen, NULL) &&
+           ParserClose(parser, kPasNodeCall, kPasTokenTypeZero, token, base);
+    } else if (type == kPasTokenTypeLBracket ||
+               type == kPasTokenTypeLBracket2) {
+      ParserAdvance(parser);
+      do {
+        if (!ParseExpression(parser)) {
+          return false;
+        }
+      } while (ParserAccept(parser, kPasTokenTypeComma));
+      ok = ParserExpect(parser,
+                        type == kPasTokenTypeLBracket
+                            ? kPasTokenTypeRBracket
+                            : kPasTokenTypeRBracket2,
+                        NULL) &&
+           ParserClose(parser, kPasNodeIndex, kPasTokenTypeZero, token, base);
+    } else if (type == kPasTokenTypeDot &&
+               ParserPeekNext(parser) == kPasTokenTypeIdent) {
+      ParserAdvance(parser);
+      ok = ParserClose(parser, kPasNodeField, kPasTokenTypeZero,
+                       ParserAdvance(parser), base);
+    } else if (type == kPasTokenTypePointer) {
+      ParserAdvance(parser);
+      ok = ParserClose(parser, kPasNodeDeref, kPasTokenTypeZero, token, base);
+    } else {
+      return true;
+    }
+    if (!ok) {
+      return false;
+    }
+  }
+}
+
+// Parses a call argument, which may carry Write-style :width:precision.
+bool ParseArgument(Parser* parser) {
+  uint64_t base = parser->stack.size;
+  if (!ParseExpression(parser)) {
+    return false;
+  }
+  uint32_t token = parser->index;
+  if (!ParserAccept(parser, kPasTokenTypeColon)) {
+    return true;
+  }
+  return ParseExpression(parser) &&
+         (!ParserAccept(parser, kPasTokenTypeColon) ||
+          ParseExpression(parser)) &&
+         ParserClose(parser, kPasNodeFormat, kPasTokenTypeZero, token, base);
+}
+
+// Moves the children pushed since `base` into the tree and pushes the new
+// node in their place.
+bool ParserClose(Parser* parser,
+                 PasNodeKind kind,
+                 PasTokenType op,
+                 uint32_t token,
+                 uint64_t base) {
+  PasAst* ast = parser->ast;
+  uint64_t count = parser->stack.size - base;
+  PasNode node = {
+      .kind = (uint8_t)kind,
+      .op = (uint8_t)op,
+      .token = token,
+      .children = (uint32_t)ast->children.size,
+      .child_count = (uint32_t)count,
+  };
+  if (ast->nodes.size >= UINT32_MAX ||
+      ast->children.size + count > UINT32_MAX ||
+      (count > 0 &&
+       !VEC_APPEND(&ast->children, parser->stack.data + base, count)) ||
+      !VEC_PUSH(&ast->nodes, node)) {
+    return ParserFail(parser, "out of memory", kPasTokenTypeZero);
+  }
+  parser->stack.size = base;
+  if (!VEC_PUSH(&parser->stack, (uint32_t)(ast->nodes.size - 1))) {
+    return ParserFail(parser, "out of memory", kPasTokenTypeZero);
+  }
+  return true;
+}
+
+bool ParserLeaf(Parser* parser, PasNodeKind kind, uint32_t token) {
+  return ParserClose(parser, kind, kPasTokenTypeZero, token,
+                     parser->stack.size);
+}
+
+// Callers decrement `depth` when done.
+bool ParserEnter(Parser* parser) {
+  if (parser->depth == PARSER_MAX_DEPTH) {
+    return ParserFail(parser, "nesting too deep", kPasTokenTypeZero);
+  }
+  parser->depth++;
+  return true;
+}
+
+// Records the first error only; later ones are consequences of it.
+bool ParserFail(Parser* parser, const char* message, PasTokenType expected) {
+  if (parser->error->message == NULL) {
+    *parser->error = (PasParseError){
+        .position = ParserPosition(parser, parser->index),
+        .message = message,
+        .expected = expected,
+    };
+  }
+  return false;
+}
+
+bool ParserAtEnd(const Parser* parser) {
+  return parser->index >= parser->count;
+}
+
+PasTokenType ParserPeek(const Parser* parser) {
+  return ParserAtEnd(parser)
+             ? kPasTokenTypeZero
+             : PasTokenStreamType(parser->tokens, parser->index);
+}
+
+PasTokenType ParserPeekNext(const Parser* parser) {
+  if (ParserAtEnd(parser)) {
+    return kPasTokenTypeZero;
+  }
+  uint64_t next = ParserSkipTrivia(parser, parser->index + 1);
+  return next < parser->count ? PasTokenStreamType(parser->tokens, next)
+                              : kPasTokenTypeZero;
+}
+
+uint64_t ParserSkipTrivia(const Parser* parser, uint64_t index) {
+  while (index < parser->count &&
+         PasTokenTypeIsTrivia(PasTokenStreamType(parser->tokens, index))) {
+    index++;
+  }
+  return index;
+}
+
+// Returns the current token and moves to the next significant one.
+uint32_t ParserAdvance(Parser* parser) {
+  uint32_t token = (uint32_t)parser->index;
+  if (!ParserAtEnd(parser)) {
+    parser->end = PasTokenStreamPosition(parser->tokens, token) +
+                  PasTokenStreamLength(parser->tokens, token);
+    parser->index = ParserSkipTrivia(parser, parser->index + 1);
+  }
+  return token;
+}
+
+bool ParserAccept(Parser* parser, PasTokenType type) {
+  if (ParserAtEnd(parser) || ParserPeek(parser) != type) {
+    return false;
+  }
+  ParserAdvance(parser);
+  return true;
+}
+
+bool ParserExpect(Parser* parser, PasTokenType type, uint32_t* token) {
+  uint32_t index = (uint32_t)parser->index;
+  if (!ParserAccept(parser, type)) {
+    return ParserFail(parser, "expected", type);
+  }
+  if (token != NULL) {
+    *token = index;
+  }
+  return true;
+}
+
+bool ParserExpectName(Parser* parser, uint32_t* token) {
+  if (!ParserIsName(parser)) {
+    return ParserFail(parser, "expected", kPasTokenTypeIdent);
+  }
+  uint32_t index = ParserAdvance(parser);
+  if (token != NULL) {
+    *token = index;
+  }
+  return true;
+}
+
+// Predeclared type and function names are keywords to the lexer but names
+// to the parser.
+bool ParserIsName(const Parser* parser) {
+  if (ParserAtEnd(parser)) {
+    return false;
+  }
+  switch (ParserPeek(parser)) {
+    case kPasTokenTypeIdent:
+    case kPasTokenTypeBoolean:
+    case kPasTokenTypeChar:
+    case kPasTokenTypeChr:
+    case kPasTokenTypeInteger:
+    case kPasTokenTypeReal:
+    case kPasTokenTypeString:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// A routine directive is a name followed by ';' or, for external, by
+// arguments.
+bool ParserIsDirective(const Parser* parser) {
+  static const char* const kDirectives[] = {
+      "assembler", "cdecl", "external", "far",    "forward",
+      "inline",    "near",  "pascal",   "stdcall",
+  };
+  if (ParserPeek(parser) != kPasTokenTypeIdent) {
+    return false;
+  }
+  for (size_t i = 0; i < sizeof kDirectives / sizeof kDirectives[0]; ++i) {
+    if (ParserTextIs(parser, kDirectives[i])) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Compares the current token case-insensitively with `word`.
+bool ParserTextIs(const Parser* parser, const char* word) {
+  if (ParserAtEnd(parser)) {
+    return false;
+  }
+  uint64_t length = PasTokenStreamLength(parser->tokens, parser->index);
+  return strlen(word) == length &&
+         strncasecmp(parser->text.data + ParserPosition(parser, parser->index),
+                     word, length) == 0;
+}
+
+// '#' has no token type of its own.
+bool ParserIsHash(const Parser* parser) {
+  return !ParserAtEnd(parser) && ParserPeek(parser) == kPasTokenTypeZero &&
+         parser->text.data[ParserPosition(parser, parser->index)] == '#';
+}
+
+uint64_t ParserPosition(const Parser* parser, uint64_t index) {
+  return index < parser->count ? PasTokenStreamPosition(parser->tokens, index)
+                               : parser->text.size;
+}
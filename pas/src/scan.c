@@ -0,0 +1,220 @@
+#include "pas/scan.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SCAN_X86 1
+#else
+#define SCAN_X86 0
+#endif
+
+static bool IsWhiteSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static bool IsIdentifierPart(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+         (c >= '0' && c <= '9') || c == '_';
+}
+
+static const char* ScanWhitespaceScalar(const char* begin) {
+  while (IsWhiteSpace(*begin)) {
+    begin++;
+  }
+  return begin;
+}
+
+static const char* ScanIdentifierScalar(const char* begin) {
+  while (IsIdentifierPart(*begin)) {
+    begin++;
+  }
+  return begin;
+}
+
+static const char* ScanBraceCommentScalar(const char* begin) {
+  while (*begin != '}' && *begin != '\0') {
+    begin++;
+  }
+  return begin;
+}
+
+static const char* ScanParenCommentScalar(const char* begin) {
+  while (*begin != '*' && *begin != '\0') {
+    begin++;
+  }
+  return begin;
+}
+
+static const char* ScanQuoteScalar(const char* begin) {
+  while (*begin != '\'' && *begin != '\0') {
+    begin++;
+  }
+  return begin;
+}
+
+static uint64_t CountNewlinesScalar(const char* begin, const char* end) {
+  uint64_t count = 0;
+  while (begin < end) {
+    count += *begin++ == '\n';
+  }
+  return count;
+}
+
+static const PasScanKernels kScalarKernels = {
+    .name = "scalar",
+    .whitespace = ScanWhitespaceScalar,
+    .identifier = ScanIdentifierScalar,
+    .brace_comment = ScanBraceCommentScalar,
+    .paren_comment = ScanParenCommentScalar,
+    .quote = ScanQuoteScalar,
+    .newlines = CountNewlinesScalar,
+};
+
+#if SCAN_X86
+
+// Each vector kernel builds a mask of bytes that end the run and stops at the
+// lowest set bit. Every run ends at the NUL padding, so a load never starts
+// more than one vector width before the padding ends.
+#define SCAN_VECTOR_KERNEL(Name, Width, Target, Vec, Load, Mask)             \
+  __attribute__((target(Target))) static const char* Name(const char* begin) { \
+    while (true) {                                                           \
+      Vec v = Load((const Vec*)begin);                                       \
+      uint32_t stop = (uint32_t)(Mask);                                      \
+      if (stop != 0) {                                                       \
+        return begin + __builtin_ctz(stop);                                  \
+      }                                                                      \
+      begin += (Width);                                                      \
+    }                                                                        \
+  }
+
+#define SSE2_EQ(C) _mm_cmpeq_epi8(v, _mm_set1_epi8(C))
+#define SSE2_IN_RANGE(X, Lo, Count)                                 \
+  _mm_cmplt_epi8(_mm_add_epi8((X), _mm_set1_epi8((char)(0x80 - (Lo)))), \
+                 _mm_set1_epi8((char)(0x80 + (Count))))
+#define SSE2_IDENTIFIER                                                   \
+  _mm_or_si128(                                                           \
+      _mm_or_si128(SSE2_IN_RANGE(_mm_or_si128(v, _mm_set1_epi8(0x20)), 'a', \
+                                 26),                                     \
+                   SSE2_IN_RANGE(v, '0', 10)),                            \
+      SSE2_EQ('_'))
+
+SCAN_VECTOR_KERNEL(ScanWhitespaceSse2, 16, "sse2", __m128i, _mm_loadu_si128,
+                   ~_mm_movemask_epi8(_mm_or_si128(
+                       _mm_or_si128(SSE2_EQ(' '), SSE2_EQ('\t')),
+                       _mm_or_si128(SSE2_EQ('\n'), SSE2_EQ('\r')))) &
+                       0xFFFF)
+SCAN_VECTOR_KERNEL(ScanIdentifierSse2, 16, "sse2", __m128i, _mm_loadu_si128,
+                   ~_mm_movemask_epi8(SSE2_IDENTIFIER) & 0xFFFF)
+SCAN_VECTOR_KERNEL(ScanBraceCommentSse2, 16, "sse2", __m128i,
+                   _mm_loadu_si128,
+                   _mm_movemask_epi8(_mm_or_si128(SSE2_EQ('}'),
+                                                  SSE2_EQ('\0'))))
+SCAN_VECTOR_KERNEL(ScanParenCommentSse2, 16, "sse2", __m128i,
+                   _mm_loadu_si128,
+                   _mm_movemask_epi8(_mm_or_si128(SSE2_EQ('*'),
+                                                  SSE2_EQ('\0'))))
+SCAN_VECTOR_KERNEL(ScanQuoteSse2, 16, "sse2", __m128i, _mm_loadu_si128,
+                   _mm_movemask_epi8(_mm_or_si128(SSE2_EQ('\''),
+                                                  SSE2_EQ('\0'))))
+
+#define AVX2_EQ(C) _mm256_cmpeq_epi8(v, _mm256_set1_epi8(C))
+#define AVX2_IN_RANGE(X, Lo, Count)                                     \
+  _mm256_cmpgt_epi8(                                                    \
+      _mm256_set1_epi8((char)(0x80 + (Count))),                         \
+      _mm256_add_epi8((X), _mm256_set1_epi8((char)(0x80 - (Lo)))))
+#define AVX2_IDENTIFIER                                                \
+  _mm256_or_si256(                                                     \
+      _mm256_or_si256(                                                 \
+          AVX2_IN_RANGE(_mm256_or_si256(v, _mm256_set1_epi8(0x20)), 'a', \
+                        26),                                           \
+          AVX2_IN_RANGE(v, '0', 10)),                                  \
+      AVX2_EQ('_'))
+
+SCAN_VECTOR_KERNEL(ScanWhitespaceAvx2, 32, "avx2", __m256i,
+                   _mm256_loadu_si256,
+                   ~_mm256_movemask_epi8(_mm256_or_si256(
+                       _mm256_or_si256(AVX2_EQ(' '), AVX2_EQ('\t')),
+                       _mm256_or_si256(AVX2_EQ('\n'), AVX2_EQ('\r')))))
+SCAN_VECTOR_KERNEL(ScanIdentifierAvx2, 32, "avx2", __m256i,
+                   _mm256_loadu_si256, ~_mm256_movemask_epi8(AVX2_IDENTIFIER))
+SCAN_VECTOR_KERNEL(ScanBraceCommentAvx2, 32, "avx2", __m256i,
+                   _mm256_loadu_si256,
+                   _mm256_movemask_epi8(_mm256_or_si256(AVX2_EQ('}'),
+                                                        AVX2_EQ('\0'))))
+SCAN_VECTOR_KERNEL(ScanParenCommentAvx2, 32, "avx2", __m256i,
+                   _mm256_loadu_si256,
+                   _mm256_movemask_epi8(_mm256_or_si256(AVX2_EQ('*'),
+                                                        AVX2_EQ('\0'))))
+SCAN_VECTOR_KERNEL(ScanQuoteAvx2, 32, "avx2", __m256i, _mm256_loadu_si256,
+                   _mm256_movemask_epi8(_mm256_or_si256(AVX2_EQ('\''),
+                                                        AVX2_EQ('\0'))))
+
+#define COUNT_VECTOR_KERNEL(Name, Width, Target, Vec, Load, Mask)       \
+  __attribute__((target(Target))) static uint64_t Name(const char* begin, \
+                                                       const char* end) { \
+    uint64_t count = 0;                                                   \
+    while (end - begin >= (Width)) {                                      \
+      Vec v = Load((const Vec*)begin);                                    \
+      count += (uint64_t)__builtin_popcount((uint32_t)(Mask));            \
+      begin += (Width);                                                   \
+    }                                                                     \
+    return count + CountNewlinesScalar(begin, end);                       \
+  }
+
+COUNT_VECTOR_KERNEL(CountNewlinesSse2, 16, "sse2", __m128i, _mm_loadu_si128,
+                    _mm_movemask_epi8(SSE2_EQ('\n')))
+COUNT_VECTOR_KERNEL(CountNewlinesAvx2, 32, "avx2,popcnt", __m256i,
+                    _mm256_loadu_si256, _mm256_movemask_epi8(AVX2_EQ('\n')))
+
+static const PasScanKernels kSse2Kernels = {
+    .name = "sse2",
+    .whitespace = ScanWhitespaceSse2,
+    .identifier = ScanIdentifierSse2,
+    .brace_comment = ScanBraceCommentSse2,
+    .paren_comment = ScanParenCommentSse2,
+    .quote = ScanQuoteSse2,
+    .newlines = CountNewlinesSse2,
+};
+
+static const PasScanKernels kAvx2Kernels = {
+    .name = "avx2",
+    .whitespace = ScanWhitespaceAvx2,
+    .identifier = ScanIdentifierAvx2,
+    .brace_comment = ScanBraceCommentAvx2,
+    .paren_comment = ScanParenCommentAvx2,
+    .quote = ScanQuoteAvx2,
+    .newlines = CountNewlinesAvx2,
+};
+
+#endif
+
+const PasScanKernels* PasScanKernelsFor(PasScanLevel level) {
+  switch (level) {
+    case kPasScanLevelScalar:
+      return &kScalarKernels;
+#if SCAN_X86
+    case kPasScanLevelSse2:
+      return __builtin_cpu_supports("sse2") ? &kSse2Kernels : NULL;
+    case kPasScanLevelAvx2:
+      // CountNewlinesAvx2 is built for popcnt as well.
+      return __builtin_cpu_supports("avx2") &&
+                     __builtin_cpu_supports("popcnt")
+                 ? &kAvx2Kernels
+                 : NULL;
+#endif
+    default:
+      return NULL;
+  }
+}
+
+const PasScanKernels* PasScanKernelsBest(void) {
+  for (int level = kPasScanLevelAvx2; level > kPasScanLevelScalar; --level) {
+    const PasScanKernels* kernels = PasScanKernelsFor((PasScanLevel)level);
+    if (kernels != NULL) {
+      return kernels;
+    }
+  }
+  return &kScalarKernels;
+}
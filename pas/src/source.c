@@ -0,0 +1,180 @@
+#include "pas/source.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SOURCE_READ_CHUNK (64 * 1024)
+
+static const char kEmptySource[PAS_SOURCE_PADDING] = {0};
+
+static bool SourceMap(PasSource* source, int fd, uint64_t size);
+static bool SourceReadExact(PasSource* source, int fd, uint64_t size);
+static bool SourceReadAll(PasSource* source, int fd);
+static uint64_t RoundUp(uint64_t n, uint64_t multiple);
+
+bool PasSourceOpen(PasSource* source, const char* path) {
+  if (strcmp(path, "-") == 0) {
+    return PasSourceReadFd(source, STDIN_FILENO);
+  }
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  bool result = PasSourceReadFd(source, fd);
+  int saved_errno = errno;
+  close(fd);
+  errno = saved_errno;
+  return result;
+}
+
+bool PasSourceReadFd(PasSource* source, int fd) {
+  *source = (PasSource){.data = kEmptySource};
+  struct stat st;
+  if (fstat(fd, &st) < 0) {
+    return false;
+  }
+  if (!S_ISREG(st.st_mode)) {
+    return SourceReadAll(source, fd);
+  }
+  uint64_t size = (uint64_t)st.st_size;
+  if (size == 0) {
+    return true;
+  }
+  if (SourceMap(source, fd, size)) {
+    return true;
+  }
+  return SourceReadExact(source, fd, size);
+}
+
+bool PasSourceFromMemory(PasSource* source, const char* data, uint64_t size) {
+  *source = (PasSource){.data = kEmptySource};
+  if (size == 0) {
+    return true;
+  }
+  char* copy = calloc(size + PAS_SOURCE_PADDING, 1);
+  if (copy == NULL) {
+    errno = ENOMEM;
+    return false;
+  }
+  memcpy(copy, data, size);
+  source->data = copy;
+  source->size = size;
+  return true;
+}
+
+void PasSourceClose(PasSource* source) {
+  if (source->mapping != NULL) {
+    munmap(source->mapping, source->mapping_size);
+  } else if (source->data != kEmptySource) {
+    free((char*)source->data);
+  }
+  *source = (PasSource){.data = kEmptySource};
+}
+
+StringView PasSourceView(const PasSource* source) {
+  return StringViewMake(source->data, source->size);
+}
+
+// Reserves the file's pages plus the padding as one anonymous zero mapping,
+// then maps the file over its start. The tail of the last file page and any
+// following anonymous pages read as zero.
+bool SourceMap(PasSource* source, int fd, uint64_t size) {
+  uint64_t page = (uint64_t)sysconf(_SC_PAGESIZE);
+  uint64_t total = RoundUp(size + PAS_SOURCE_PADDING, page);
+  void* base =
+      mmap(NULL, total, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (base == MAP_FAILED) {
+    return false;
+  }
+  if (mmap(base, RoundUp(size, page), PROT_READ, MAP_PRIVATE | MAP_FIXED, fd,
+           0) == MAP_FAILED) {
+    munmap(base, total);
+    return false;
+  }
+  madvise(base, size, MADV_SEQUENTIAL);
+  source->data = base;
+  source->size = size;
+  source->mapping = base;
+  source->mapping_size = total;
+  return true;
+}
+
+bool SourceReadExact(PasSource* source, int fd, uint64_t size) {
+  char* data = malloc(size + PAS_SOURCE_PADDING);
+  if (data == NULL) {
+    errno = ENOMEM;
+    return false;
+  }
+  uint64_t filled = 0;
+  while (filled < size) {
+    ssize_t n = read(fd, data + filled, size - filled);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0) {
+      int saved_errno = errno;
+      free(data);
+      errno = saved_errno;
+      return false;
+    }
+    if (n == 0) {
+      break;
+    }
+    filled += (uint64_t)n;
+  }
+  if (filled == 0) {
+    free(data);
+    return true;
+  }
+  memset(data + filled, 0, PAS_SOURCE_PADDING);
+  source->data = data;
+  source->size = filled;
+  return true;
+}
+
+bool SourceReadAll(PasSource* source, int fd) {
+  String data = {0};
+  while (true) {
+    if (data.size + PAS_SOURCE_PADDING >= data.capacity &&
+        !VEC_RESERVE(&data, data.capacity == 0 ? SOURCE_READ_CHUNK
+                                               : data.capacity * 2)) {
+      VEC_FREE(&data);
+      errno = ENOMEM;
+      return false;
+    }
+    ssize_t n = read(fd, data.data + data.size,
+                     data.capacity - data.size - PAS_SOURCE_PADDING);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0) {
+      int saved_errno = errno;
+      VEC_FREE(&data);
+      errno = saved_errno;
+      return false;
+    }
+    if (n == 0) {
+      break;
+    }
+    data.size += (uint64_t)n;
+  }
+  if (data.size == 0) {
+    VEC_FREE(&data);
+    return true;
+  }
+  memset(data.data + data.size, 0, PAS_SOURCE_PADDING);
+  source->data = data.data;
+  source->size = data.size;
+  return true;
+}
+
+uint64_t RoundUp(uint64_t n, uint64_t multiple) {
+  return (n + multiple - 1) / multiple * multiple;
+}
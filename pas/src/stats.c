@@ -0,0 +1,162 @@
+#include "pas/stats.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "lex_stats.h"
+
+#if defined(PAS_STATS) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#endif
+
+const char* const kPasLexBranchNames[] = {
+#define X(x) #x,
+    PAS_LEX_BRANCH_VARIANTS_
+#undef X
+};
+
+#ifdef PAS_STATS
+// Distinct allocators that can be counted; vecs using any more are not.
+#define STATS_ALLOCATORS 64
+
+static void* StatsReallocate(void* context,
+                             void* ptr,
+                             uint64_t old_size,
+                             uint64_t new_size);
+static void StatsRelease(void* context, void* ptr, uint64_t size);
+
+_Thread_local PasLexStats pas_lex_stats_local;
+
+static PasLexStats stats_total;
+static pthread_mutex_t stats_lock = PTHREAD_MUTEX_INITIALIZER;
+// A counting allocator per allocator passed to PasLexStatsAllocator, with the
+// one it wraps as its context. Vecs keep a pointer to their allocator, so
+// entries are never removed.
+static VecAllocator stats_allocators[STATS_ALLOCATORS];
+static uint32_t stats_allocator_count;
+
+bool PasLexStatsGet(PasLexStats* stats) {
+  PasLexStatsFlush();
+  pthread_mutex_lock(&stats_lock);
+  *stats = stats_total;
+  pthread_mutex_unlock(&stats_lock);
+  return true;
+}
+
+void PasLexStatsReset(void) {
+  pas_lex_stats_local = (PasLexStats){0};
+  pthread_mutex_lock(&stats_lock);
+  stats_total = (PasLexStats){0};
+  pthread_mutex_unlock(&stats_lock);
+}
+
+uint64_t PasLexStatsTicks(void) {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#elif defined(__aarch64__)
+  uint64_t ticks;
+  __asm__ volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+  return ticks;
+#else
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000 + (uint64_t)now.tv_nsec;
+#endif
+}
+
+const VecAllocator* PasLexStatsAllocator(const VecAllocator* allocator) {
+  if (allocator != NULL && allocator->reallocate == StatsReallocate) {
+    return allocator;
+  }
+  const VecAllocator* result = allocator;
+  pthread_mutex_lock(&stats_lock);
+  for (uint32_t i = 0; i < stats_allocator_count; ++i) {
+    if (stats_allocators[i].context == allocator) {
+      result = &stats_allocators[i];
+      break;
+    }
+  }
+  if (result == allocator && stats_allocator_count < STATS_ALLOCATORS) {
+    stats_allocators[stats_allocator_count] = (VecAllocator){
+        .reallocate = StatsReallocate,
+        .release = StatsRelease,
+        .context = (void*)allocator,
+    };
+    result = &stats_allocators[stats_allocator_count++];
+  }
+  pthread_mutex_unlock(&stats_lock);
+  return result;
+}
+
+// PasLexStats is all uint64_t counters, so it can be summed as an array.
+void PasLexStatsFlush(void) {
+  const uint64_t* local = (const uint64_t*)&pas_lex_stats_local;
+  uint64_t* total = (uint64_t*)&stats_total;
+  pthread_mutex_lock(&stats_lock);
+  for (size_t i = 0; i < sizeof(PasLexStats) / sizeof(uint64_t); ++i) {
+    total[i] += local[i];
+  }
+  pthread_mutex_unlock(&stats_lock);
+  pas_lex_stats_local = (PasLexStats){0};
+}
+
+void* StatsReallocate(void* context,
+                      void* ptr,
+                      uint64_t old_size,
+                      uint64_t new_size) {
+  const VecAllocator* allocator = context;
+  void* result = allocator == NULL
+                     ? realloc(ptr, new_size)
+                     : allocator->reallocate(allocator->context, ptr,
+                                             old_size, new_size);
+  if (result != NULL) {
+    pthread_mutex_lock(&stats_lock);
+    stats_total.allocations++;
+    stats_total.allocation_bytes += new_size - old_size;
+    pthread_mutex_unlock(&stats_lock);
+  }
+  return result;
+}
+
+void StatsRelease(void* context, void* ptr, uint64_t size) {
+  const VecAllocator* allocator = context;
+  if (allocator == NULL) {
+    free(ptr);
+  } else {
+    allocator->release(allocator->context, ptr, size);
+  }
+}
+#else
+bool PasLexStatsGet(PasLexStats* stats) {
+  *stats = (PasLexStats){0};
+  return false;
+}
+
+void PasLexStatsReset(void) {}
+#endif
+
+PasLexBranch PasLexBranchOf(PasTokenType type) {
+  switch (type) {
+    case kPasTokenTypeIdent:
+#define X(x) case kPasTokenType##x:
+      PAS_TOKEN_KEYWORD_VARIANTS_
+#undef X
+      return kPasLexBranchIdentifier;
+    case kPasTokenTypeNumInt:
+    case kPasTokenTypeNumReal:
+      return kPasLexBranchNumber;
+    case kPasTokenTypeWs:
+      return kPasLexBranchWhitespace;
+    case kPasTokenTypeComment1:
+    case kPasTokenTypeComment2:
+      return kPasLexBranchComment;
+    case kPasTokenTypeStringLiteral:
+      return kPasLexBranchString;
+    default:
+      return kPasLexBranchPunctuation;
+  }
+}
@@ -6,28 +6,19 @@
 
 String StringMake(const char* left, const char* right) {
   String s = {0};
-  VEC_RESERVE(&s, right - left);
-  for (const char* c = left; c < right; c++) {
-    VEC_PUSH(&s, *c);
-  }
+  VEC_APPEND(&s, left, right - left);
   return s;
 }
 
 String StringMakeC(const char* c) {
   String s = {0};
-  VEC_RESERVE(&s, strlen(c));
-  for (const char* p = c; *p != '\0'; p++) {
-    VEC_PUSH(&s, *p);
-  }
+  VEC_APPEND(&s, c, strlen(c));
   return s;
 }
 
 String StringDuplicate(const String* s) {
   String dup = {0};
-  VEC_RESERVE(&dup, s->size);
-  for (uint64_t i = 0; i < s->size; i++) {
-    VEC_PUSH(&dup, s->data[i]);
-  }
+  VEC_APPEND(&dup, s->data, s->size);
   return dup;
 }
 
@@ -38,3 +29,22 @@ void StringDowncase(String* s) {
     }
   }
 }
+
+StringView StringViewMake(const char* data, uint64_t size) {
+  return (StringView){.data = data, .size = size};
+}
+
+StringView StringViewOf(const String* s) {
+  return StringViewMake(s->data, s->size);
+}
+
+String StringFromView(StringView v) {
+  return StringMake(v.data, v.data + v.size);
+}
+
+String StringFromViewWith(StringView v, const VecAllocator* allocator) {
+  String s = {0};
+  VEC_SET_ALLOCATOR(&s, allocator);
+  VEC_APPEND(&s, v.data, v.size);
+  return s;
+}
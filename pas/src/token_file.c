@@ -0,0 +1,371 @@
+#include "pas/token_file.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TOKEN_FILE_ALIGN 8
+// Room for the ".tmp.", process id and attempt appended to the path while
+// writing, and how many names to try before giving up.
+#define TOKEN_FILE_TEMP_SUFFIX 48
+#define TOKEN_FILE_TEMP_ATTEMPTS 100
+
+#define HASH_PRIME1 0x9E3779B185EBCA87ull
+#define HASH_PRIME2 0xC2B2AE3D27D4EB4Full
+#define HASH_PRIME3 0x165667B19E3779F9ull
+#define HASH_PRIME4 0x85EBCA77C2B2AE63ull
+#define HASH_PRIME5 0x27D4EB2F165667C5ull
+
+static bool TokenFileWriteTo(int fd,
+                             const PasTokenFileHeader* header,
+                             const PasTokenStream* tokens);
+static bool TokenFileWriteAll(int fd, const void* data, uint64_t size);
+static bool TokenFileCheck(const PasTokenFileHeader* header,
+                           uint64_t size,
+                           StringView source);
+static bool TokenFileCheckTokens(const PasTokenFileHeader* header);
+static bool TokenFileArray(uint64_t offset,
+                           uint64_t count,
+                           uint64_t width,
+                           uint64_t size);
+static void* TokenFileReallocate(void* context,
+                                 void* ptr,
+                                 uint64_t old_size,
+                                 uint64_t new_size);
+static void TokenFileRelease(void* context, void* ptr, uint64_t size);
+static uint64_t HashRound(uint64_t accumulator, uint64_t input);
+static uint64_t HashMerge(uint64_t accumulator, uint64_t value);
+static uint64_t HashLoad64(const char* p);
+static uint32_t HashLoad32(const char* p);
+static uint64_t RotateLeft(uint64_t value, int count);
+static uint64_t AlignUp(uint64_t n);
+
+// Makes the vecs of a mapped stream refuse to grow and skip freeing.
+static const VecAllocator kTokenFileAllocator = {
+    .reallocate = TokenFileReallocate,
+    .release = TokenFileRelease,
+};
+
+uint64_t PasTokenFileHash(StringView source) {
+  const char* p = source.data;
+  const char* end = p + source.size;
+  uint64_t hash;
+  if (source.size >= 32) {
+    uint64_t v1 = HASH_PRIME1 + HASH_PRIME2;
+    uint64_t v2 = HASH_PRIME2;
+    uint64_t v3 = 0;
+    uint64_t v4 = -HASH_PRIME1;
+    for (; end - p >= 32; p += 32) {
+      v1 = HashRound(v1, HashLoad64(p));
+      v2 = HashRound(v2, HashLoad64(p + 8));
+      v3 = HashRound(v3, HashLoad64(p + 16));
+      v4 = HashRound(v4, HashLoad64(p + 24));
+    }
+    hash = RotateLeft(v1, 1) + RotateLeft(v2, 7) + RotateLeft(v3, 12) +
+           RotateLeft(v4, 18);
+    hash = HashMerge(hash, v1);
+    hash = HashMerge(hash, v2);
+    hash = HashMerge(hash, v3);
+    hash = HashMerge(hash, v4);
+  } else {
+    hash = HASH_PRIME5;
+  }
+  hash += source.size;
+  for (; end - p >= 8; p += 8) {
+    hash ^= HashRound(0, HashLoad64(p));
+    hash = RotateLeft(hash, 27) * HASH_PRIME1 + HASH_PRIME4;
+  }
+  if (end - p >= 4) {
+    hash ^= HashLoad32(p) * HASH_PRIME1;
+    hash = RotateLeft(hash, 23) * HASH_PRIME2 + HASH_PRIME3;
+    p += 4;
+  }
+  for (; p < end; ++p) {
+    hash ^= (uint8_t)*p * HASH_PRIME5;
+    hash = RotateLeft(hash, 11) * HASH_PRIME1;
+  }
+  hash ^= hash >> 33;
+  hash *= HASH_PRIME2;
+  hash ^= hash >> 29;
+  hash *= HASH_PRIME3;
+  hash ^= hash >> 32;
+  return hash;
+}
+
+bool PasTokenFileWrite(const char* path,
+                       const PasTokenStream* tokens,
+                       StringView source) {
+  uint64_t count = PasTokenStreamSize(tokens);
+  uint64_t width = tokens->wide ? sizeof(uint64_t) : sizeof(uint32_t);
+  PasTokenFileHeader header = {
+      .magic = PAS_TOKEN_FILE_MAGIC,
+      .version = PAS_TOKEN_FILE_VERSION,
+      .flags = tokens->wide ? kPasTokenFileWide : 0,
+      .count = count,
+      .source_size = source.size,
+      .source_hash = PasTokenFileHash(source),
+  };
+  header.types = sizeof(header);
+  header.positions = AlignUp(header.types + count);
+  header.lengths = AlignUp(header.positions + count * width);
+  // The file is written beside `path` and renamed over it, so a reader never
+  // maps a half-written file and a failure leaves the old one in place.
+  char* temp = malloc(strlen(path) + TOKEN_FILE_TEMP_SUFFIX);
+  if (temp == NULL) {
+    errno = ENOMEM;
+    return false;
+  }
+  // O_EXCL neither truncates nor follows whatever is already at the name;
+  // another name is tried instead.
+  int fd = -1;
+  for (int attempt = 0; fd < 0 && attempt < TOKEN_FILE_TEMP_ATTEMPTS;
+       ++attempt) {
+    sprintf(temp, "%s.tmp.%ld.%d", path, (long)getpid(), attempt);
+    fd = open(temp, O_WRONLY | O_CREAT | O_EXCL, 0644);
+    if (fd < 0 && errno != EEXIST) {
+      break;
+    }
+  }
+  if (fd < 0) {
+    free(temp);
+    return false;
+  }
+  bool result = TokenFileWriteTo(fd, &header, tokens);
+  int saved_errno = errno;
+  if (close(fd) < 0 && result) {
+    result = false;
+    saved_errno = errno;
+  }
+  if (result && rename(temp, path) < 0) {
+    result = false;
+    saved_errno = errno;
+  }
+  if (!result) {
+    unlink(temp);
+  }
+  free(temp);
+  errno = saved_errno;
+  return result;
+}
+
+bool PasTokenFileOpen(PasTokenFile* file, const char* path, StringView source) {
+  *file = (PasTokenFile){0};
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) < 0) {
+    int saved_errno = errno;
+    close(fd);
+    errno = saved_errno;
+    return false;
+  }
+  uint64_t size = (uint64_t)st.st_size;
+  if (size < sizeof(PasTokenFileHeader)) {
+    close(fd);
+    errno = EINVAL;
+    return false;
+  }
+  void* mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  int saved_errno = errno;
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    errno = saved_errno;
+    return false;
+  }
+  const PasTokenFileHeader* header = mapping;
+  if (!TokenFileCheck(header, size, source)) {
+    saved_errno = errno;
+    munmap(mapping, size);
+    errno = saved_errno;
+    return false;
+  }
+  file->mapping = mapping;
+  file->size = size;
+  bool wide = (header->flags & kPasTokenFileWide) != 0;
+  PasTokenStreamInit(&file->tokens, wide, &kTokenFileAllocator);
+  uint64_t count = header->count;
+  char* base = mapping;
+  file->tokens.types.data = (uint8_t*)(base + header->types);
+  file->tokens.types.size = count;
+  file->tokens.types.capacity = count;
+  if (wide) {
+    file->tokens.positions64.data = (uint64_t*)(base + header->positions);
+    file->tokens.positions64.size = count;
+    file->tokens.positions64.capacity = count;
+    file->tokens.lengths64.data = (uint64_t*)(base + header->lengths);
+    file->tokens.lengths64.size = count;
+    file->tokens.lengths64.capacity = count;
+  } else {
+    file->tokens.positions.data = (uint32_t*)(base + header->positions);
+    file->tokens.positions.size = count;
+    file->tokens.positions.capacity = count;
+    file->tokens.lengths.data = (uint32_t*)(base + header->lengths);
+    file->tokens.lengths.size = count;
+    file->tokens.lengths.capacity = count;
+  }
+  return true;
+}
+
+void PasTokenFileClose(PasTokenFile* file) {
+  if (file->mapping != NULL) {
+    munmap(file->mapping, file->size);
+  }
+  *file = (PasTokenFile){0};
+}
+
+bool TokenFileWriteTo(int fd,
+                      const PasTokenFileHeader* header,
+                      const PasTokenStream* tokens) {
+  uint64_t count = header->count;
+  uint64_t width = tokens->wide ? sizeof(uint64_t) : sizeof(uint32_t);
+  const void* positions = tokens->wide ? (const void*)tokens->positions64.data
+                                       : (const void*)tokens->positions.data;
+  const void* lengths = tokens->wide ? (const void*)tokens->lengths64.data
+                                     : (const void*)tokens->lengths.data;
+  uint64_t types_end = header->types + count;
+  uint64_t positions_end = header->positions + count * width;
+  static const char kZeros[TOKEN_FILE_ALIGN] = {0};
+  return TokenFileWriteAll(fd, header, sizeof(*header)) &&
+         TokenFileWriteAll(fd, tokens->types.data, count) &&
+         TokenFileWriteAll(fd, kZeros, header->positions - types_end) &&
+         TokenFileWriteAll(fd, positions, count * width) &&
+         TokenFileWriteAll(fd, kZeros, header->lengths - positions_end) &&
+         TokenFileWriteAll(fd, lengths, count * width);
+}
+
+bool TokenFileWriteAll(int fd, const void* data, uint64_t size) {
+  const char* p = data;
+  while (size > 0) {
+    ssize_t n = write(fd, p, size);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0) {
+      return false;
+    }
+    p += n;
+    size -= (uint64_t)n;
+  }
+  return true;
+}
+
+// Validates the header, the array bounds and every token, since the hash
+// only ties the file to the source and says nothing of how it was written.
+bool TokenFileCheck(const PasTokenFileHeader* header,
+                    uint64_t size,
+                    StringView source) {
+  uint64_t width =
+      (header->flags & kPasTokenFileWide) ? sizeof(uint64_t) : sizeof(uint32_t);
+  if (header->magic != PAS_TOKEN_FILE_MAGIC ||
+      header->version != PAS_TOKEN_FILE_VERSION ||
+      (header->flags & ~(uint32_t)kPasTokenFileWide) != 0 ||
+      header->positions % TOKEN_FILE_ALIGN != 0 ||
+      header->lengths % TOKEN_FILE_ALIGN != 0 ||
+      !TokenFileArray(header->types, header->count, 1, size) ||
+      !TokenFileArray(header->positions, header->count, width, size) ||
+      !TokenFileArray(header->lengths, header->count, width, size)) {
+    errno = EINVAL;
+    return false;
+  }
+  if (header->source_size != source.size ||
+      header->source_hash != PasTokenFileHash(source)) {
+    errno = ESTALE;
+    return false;
+  }
+  if (!TokenFileCheckTokens(header)) {
+    errno = EINVAL;
+    return false;
+  }
+  return true;
+}
+
+// Every token must have a known type and lie within the source.
+bool TokenFileCheckTokens(const PasTokenFileHeader* header) {
+  const char* base = (const char*)header;
+  const uint8_t* types = (const uint8_t*)(base + header->types);
+  bool wide = (header->flags & kPasTokenFileWide) != 0;
+  const uint32_t* positions = (const uint32_t*)(base + header->positions);
+  const uint32_t* lengths = (const uint32_t*)(base + header->lengths);
+  const uint64_t* positions64 = (const uint64_t*)(base + header->positions);
+  const uint64_t* lengths64 = (const uint64_t*)(base + header->lengths);
+  uint64_t source_size = header->source_size;
+  for (uint64_t i = 0; i < header->count; ++i) {
+    uint64_t position = wide ? positions64[i] : positions[i];
+    uint64_t length = wide ? lengths64[i] : lengths[i];
+    if (types[i] >= kPasTokenTypeCount || length > source_size ||
+        position > source_size - length) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool TokenFileArray(uint64_t offset,
+                    uint64_t count,
+                    uint64_t width,
+                    uint64_t size) {
+  return offset >= sizeof(PasTokenFileHeader) && offset <= size &&
+         count <= (size - offset) / width;
+}
+
+void* TokenFileReallocate(void* context,
+                          void* ptr,
+                          uint64_t old_size,
+                          uint64_t new_size) {
+  (void)context;
+  (void)ptr;
+  (void)old_size;
+  (void)new_size;
+  return NULL;
+}
+
+void TokenFileRelease(void* context, void* ptr, uint64_t size) {
+  (void)context;
+  (void)ptr;
+  (void)size;
+}
+
+uint64_t HashRound(uint64_t accumulator, uint64_t input) {
+  accumulator += input * HASH_PRIME2;
+  return RotateLeft(accumulator, 31) * HASH_PRIME1;
+}
+
+uint64_t HashMerge(uint64_t accumulator, uint64_t value) {
+  accumulator ^= HashRound(0, value);
+  return accumulator * HASH_PRIME1 + HASH_PRIME4;
+}
+
+uint64_t HashLoad64(const char* p) {
+  uint64_t value;
+  memcpy(&value, p, sizeof(value));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  value = __builtin_bswap64(value);
+#endif
+  return value;
+}
+
+uint32_t HashLoad32(const char* p) {
+  uint32_t value;
+  memcpy(&value, p, sizeof(value));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  value = __builtin_bswap32(value);
+#endif
+  return value;
+}
+
+uint64_t RotateLeft(uint64_t value, int count) {
+  return (value << count) | (value >> (64 - count));
+}
+
+uint64_t AlignUp(uint64_t n) {
+  return (n + TOKEN_FILE_ALIGN - 1) / TOKEN_FILE_ALIGN * TOKEN_FILE_ALIGN;
+}
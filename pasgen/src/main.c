@@ -0,0 +1,417 @@
+#include <pas/keyword.h>
+#include <pas/number.h>
+#include <pas/token.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+typedef struct {
+  const char* name;
+  PasTokenType type;
+} Keyword;
+
+static const Keyword kKeywords[] = {
+#define X(x) {#x, kPasTokenType##x},
+    PAS_TOKEN_KEYWORD_VARIANTS_
+#undef X
+};
+
+#define KEYWORD_COUNT (sizeof(kKeywords) / sizeof(kKeywords[0]))
+#define KEYWORD_MAX_LENGTH 15
+
+typedef struct {
+  const char* name;
+  const char* spelling;
+} Spelling;
+
+static const Spelling kSpellings[] = {
+#define X(x, s) {#x, s},
+    PAS_TOKEN_SPELLING_VARIANTS_
+#undef X
+};
+
+#define SPELLING_COUNT (sizeof(kSpellings) / sizeof(kSpellings[0]))
+
+// The classes the lexer dispatches on, in LexClass order. Every byte that
+// starts a spelling is an Operator.
+#define LEX_CLASS_VARIANTS_ \
+  X(Other)                  \
+  X(Identifier)             \
+  X(Digit)                  \
+  X(Space)                  \
+  X(Quote)                  \
+  X(Brace)                  \
+  X(Operator)
+
+typedef enum {
+#define X(x) kLexClass##x,
+  LEX_CLASS_VARIANTS_
+#undef X
+} LexClass;
+
+static const char* const kLexClassNames[] = {
+#define X(x) #x,
+    LEX_CLASS_VARIANTS_
+#undef X
+};
+
+// Pair rows are indexed by a byte, with row 0 left empty.
+#define LEX_MAX_PAIR_ROWS 255
+
+// Enough bits for 2^(2 * 796 + 128), the largest dividend in GeneratePow5.
+#define BIG_LIMBS 64
+
+// Little-endian fixed-width unsigned integer.
+typedef struct {
+  uint32_t limbs[BIG_LIMBS];
+} Big;
+
+static bool FindKeywordSeed(uint64_t* seed);
+static uint64_t SplitMix64(uint64_t* state);
+static int GenerateKeywords(FILE* out);
+static int GenerateLexer(FILE* out);
+static void ClassifyBytes(uint8_t* classes);
+static void EmitByteTable(FILE* out,
+                          const char* declaration,
+                          const uint8_t* values,
+                          const char* prefix,
+                          const char* const* names);
+static int GeneratePow5(FILE* out);
+static void BigPow5(Big* big, int exponent);
+static void BigQuotient(Big* quotient, int dividend_bits, const Big* divisor);
+static void BigNormalize128(Big* big);
+static void BigShiftLeft(Big* big, int bits);
+static void BigShiftRight(Big* big, int bits);
+static void BigSubtract(Big* big, const Big* other);
+static void BigIncrement(Big* big);
+static int BigCompare(const Big* a, const Big* b);
+static int BigBits(const Big* big);
+
+int main(int argc, char** argv) {
+  if (argc != 3) {
+    fprintf(stderr, "usage: %s keywords|lexer|pow5 <output>\n", argv[0]);
+    return 1;
+  }
+  FILE* out = fopen(argv[2], "w");
+  if (!out) {
+    fprintf(stderr, "Could not open %s\n", argv[2]);
+    return 1;
+  }
+  int result = 1;
+  if (strcmp(argv[1], "keywords") == 0) {
+    result = GenerateKeywords(out);
+  } else if (strcmp(argv[1], "lexer") == 0) {
+    result = GenerateLexer(out);
+  } else if (strcmp(argv[1], "pow5") == 0) {
+    result = GeneratePow5(out);
+  } else {
+    fprintf(stderr, "Unknown table %s\n", argv[1]);
+  }
+  fclose(out);
+  return result;
+}
+
+bool FindKeywordSeed(uint64_t* seed) {
+  uint64_t state = 0;
+  for (int attempt = 0; attempt < 1000000; ++attempt) {
+    uint64_t candidate = SplitMix64(&state) | 1;
+    bool used[PAS_KEYWORD_SLOTS_] = {0};
+    bool perfect = true;
+    for (uint64_t i = 0; i < KEYWORD_COUNT && perfect; ++i) {
+      const char* name = kKeywords[i].name;
+      uint32_t slot =
+          PasKeywordHash(PasKeywordKey(name, strlen(name)), candidate);
+      perfect = !used[slot];
+      used[slot] = true;
+    }
+    if (perfect) {
+      *seed = candidate;
+      return true;
+    }
+  }
+  return false;
+}
+
+uint64_t SplitMix64(uint64_t* state) {
+  uint64_t z = (*state += 0x9E3779B97F4A7C15ull);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+  return z ^ (z >> 31);
+}
+
+int GenerateKeywords(FILE* out) {
+  uint64_t seed;
+  if (!FindKeywordSeed(&seed)) {
+    fprintf(stderr, "No perfect hash seed found for the keyword table\n");
+    return 1;
+  }
+  const Keyword* slots[PAS_KEYWORD_SLOTS_] = {0};
+  uint64_t min_length = UINT64_MAX;
+  uint64_t max_length = 0;
+  for (uint64_t i = 0; i < KEYWORD_COUNT; ++i) {
+    uint64_t length = strlen(kKeywords[i].name);
+    if (length > KEYWORD_MAX_LENGTH) {
+      fprintf(stderr, "Keyword %s is too long\n", kKeywords[i].name);
+      return 1;
+    }
+    min_length = length < min_length ? length : min_length;
+    max_length = length > max_length ? length : max_length;
+    slots[PasKeywordHash(PasKeywordKey(kKeywords[i].name, length), seed)] =
+        &kKeywords[i];
+  }
+  fprintf(out, "// Generated by pasgen from PAS_TOKEN_KEYWORD_VARIANTS_.\n\n");
+  fprintf(out, "#define KEYWORD_SEED 0x%016llXull\n",
+          (unsigned long long)seed);
+  fprintf(out, "#define KEYWORD_MIN_LENGTH %llu\n",
+          (unsigned long long)min_length);
+  fprintf(out, "#define KEYWORD_MAX_LENGTH %llu\n\n",
+          (unsigned long long)max_length);
+  fprintf(out, "static const KeywordSlot kKeywordSlots[%d] = {\n",
+          PAS_KEYWORD_SLOTS_);
+  for (int i = 0; i < PAS_KEYWORD_SLOTS_; ++i) {
+    if (slots[i] == NULL) {
+      continue;
+    }
+    char lower[KEYWORD_MAX_LENGTH + 1] = {0};
+    uint64_t length = strlen(slots[i]->name);
+    for (uint64_t j = 0; j < length; ++j) {
+      lower[j] = (char)(slots[i]->name[j] | 0x20);
+    }
+    fprintf(out, "    [%d] = {\"%s\", %llu, kPasTokenType%s},\n", i, lower,
+            (unsigned long long)length, slots[i]->name);
+  }
+  fprintf(out, "};\n");
+  return 0;
+}
+
+// Emits the byte class table the lexer dispatches on, and the operator
+// tables: kLexSingle maps a byte to its one-byte token, and a two-byte
+// token is kLexPair[kLexPairRow[first]][second]. Zero marks no token.
+int GenerateLexer(FILE* out) {
+  static const char* type_names[256];
+  static uint8_t single[256];
+  static uint8_t pair_row[256];
+  static uint8_t pairs[LEX_MAX_PAIR_ROWS + 1][256];
+  uint8_t classes[256];
+  ClassifyBytes(classes);
+  int rows = 0;
+  for (uint64_t i = 0; i < SPELLING_COUNT; ++i) {
+    const Spelling* spelling = &kSpellings[i];
+    size_t length = strlen(spelling->spelling);
+    uint8_t first = (uint8_t)spelling->spelling[0];
+    if (length < 1 || length > 2) {
+      fprintf(stderr, "%s: spellings must have one or two bytes\n",
+              spelling->name);
+      return 1;
+    }
+    if (classes[first] != kLexClassOther &&
+        classes[first] != kLexClassOperator) {
+      fprintf(stderr, "%s: '%c' already starts %s tokens\n", spelling->name,
+              first, kLexClassNames[classes[first]]);
+      return 1;
+    }
+    classes[first] = kLexClassOperator;
+    type_names[i + 1] = spelling->name;
+    uint8_t* slot = &single[first];
+    if (length == 2) {
+      if (pair_row[first] == 0) {
+        if (rows == LEX_MAX_PAIR_ROWS) {
+          fprintf(stderr, "Too many two-byte spelling prefixes\n");
+          return 1;
+        }
+        pair_row[first] = (uint8_t)++rows;
+      }
+      slot = &pairs[pair_row[first]][(uint8_t)spelling->spelling[1]];
+    }
+    if (*slot != 0) {
+      fprintf(stderr, "%s: spelled like %s\n", spelling->name,
+              type_names[*slot]);
+      return 1;
+    }
+    *slot = (uint8_t)(i + 1);
+  }
+  type_names[0] = "Zero";
+  fprintf(out, "// Generated by pasgen from PAS_TOKEN_SPELLING_VARIANTS_.\n\n");
+  fprintf(out, "typedef enum {\n");
+  for (uint64_t i = 0; i < sizeof(kLexClassNames) / sizeof(char*); ++i) {
+    fprintf(out, "  kLexClass%s,\n", kLexClassNames[i]);
+  }
+  fprintf(out, "} LexClass;\n\n");
+  EmitByteTable(out, "static const uint8_t kLexClass[256]", classes,
+                "kLexClass", kLexClassNames);
+  EmitByteTable(out, "static const uint8_t kLexSingle[256]", single,
+                "kPasTokenType", type_names);
+  EmitByteTable(out, "static const uint8_t kLexPairRow[256]", pair_row, NULL,
+                NULL);
+  fprintf(out, "static const uint8_t kLexPair[%d][256] = {\n", rows + 1);
+  fprintf(out, "    {0},\n");
+  for (int row = 1; row <= rows; ++row) {
+    fprintf(out, "    {\n");
+    for (int c = 0; c < 256; ++c) {
+      if (pairs[row][c] != 0) {
+        fprintf(out, "        [0x%02X] = kPasTokenType%s,\n", c,
+                type_names[pairs[row][c]]);
+      }
+    }
+    fprintf(out, "    },\n");
+  }
+  fprintf(out, "};\n");
+  return 0;
+}
+
+void ClassifyBytes(uint8_t* classes) {
+  for (int c = 0; c < 256; ++c) {
+    if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')) {
+      classes[c] = kLexClassIdentifier;
+    } else if (c >= '0' && c <= '9') {
+      classes[c] = kLexClassDigit;
+    } else if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+      classes[c] = kLexClassSpace;
+    } else if (c == '\'') {
+      classes[c] = kLexClassQuote;
+    } else if (c == '{') {
+      classes[c] = kLexClassBrace;
+    } else {
+      classes[c] = kLexClassOther;
+    }
+  }
+}
+
+// Writes the nonzero entries of `values`, by name when `names` is given.
+void EmitByteTable(FILE* out,
+                   const char* declaration,
+                   const uint8_t* values,
+                   const char* prefix,
+                   const char* const* names) {
+  fprintf(out, "%s = {\n", declaration);
+  for (int c = 0; c < 256; ++c) {
+    if (values[c] == 0) {
+      continue;
+    }
+    if (names != NULL) {
+      fprintf(out, "    [0x%02X] = %s%s,\n", c, prefix, names[values[c]]);
+    } else {
+      fprintf(out, "    [0x%02X] = %d,\n", c, values[c]);
+    }
+  }
+  fprintf(out, "};\n\n");
+}
+
+// Emits 5^q for every q in the PasNumberParseReal range as a 128-bit value
+// with its top bit set, truncated for q >= 0. For q < 0 it is the reciprocal
+// 2^b / 5^-q plus one, which keeps the product an upper bound, as in the
+// Eisel-Lemire algorithm.
+int GeneratePow5(FILE* out) {
+  fprintf(out,
+          "// Generated by pasgen: normalized 128-bit powers of five.\n\n");
+  fprintf(out, "static const uint64_t kPow5[%d][2] = {\n",
+          PAS_NUMBER_MAX_POW10_ - PAS_NUMBER_MIN_POW10_ + 1);
+  for (int q = PAS_NUMBER_MIN_POW10_; q <= PAS_NUMBER_MAX_POW10_; ++q) {
+    Big value;
+    if (q >= 0) {
+      BigPow5(&value, q);
+    } else {
+      Big power;
+      BigPow5(&power, -q);
+      int z = BigBits(&power);
+      BigQuotient(&value, q >= -27 ? z + 127 : 2 * z + 128, &power);
+      BigIncrement(&value);
+    }
+    BigNormalize128(&value);
+    uint64_t high = (uint64_t)value.limbs[3] << 32 | value.limbs[2];
+    uint64_t low = (uint64_t)value.limbs[1] << 32 | value.limbs[0];
+    fprintf(out, "    {0x%016llXull, 0x%016llXull},  // %d\n",
+            (unsigned long long)high, (unsigned long long)low, q);
+  }
+  fprintf(out, "};\n");
+  return 0;
+}
+
+void BigPow5(Big* big, int exponent) {
+  *big = (Big){.limbs = {1}};
+  for (int i = 0; i < exponent; ++i) {
+    uint64_t carry = 0;
+    for (int j = 0; j < BIG_LIMBS; ++j) {
+      uint64_t product = (uint64_t)big->limbs[j] * 5 + carry;
+      big->limbs[j] = (uint32_t)product;
+      carry = product >> 32;
+    }
+  }
+}
+
+// Computes 2^dividend_bits / divisor by binary long division.
+void BigQuotient(Big* quotient, int dividend_bits, const Big* divisor) {
+  Big remainder = {0};
+  *quotient = (Big){0};
+  for (int bit = dividend_bits; bit >= 0; --bit) {
+    BigShiftLeft(&remainder, 1);
+    remainder.limbs[0] |= bit == dividend_bits;
+    BigShiftLeft(quotient, 1);
+    if (BigCompare(&remainder, divisor) >= 0) {
+      BigSubtract(&remainder, divisor);
+      quotient->limbs[0] |= 1;
+    }
+  }
+}
+
+// Shifts so that the highest set bit is bit 127, dropping lower bits.
+void BigNormalize128(Big* big) {
+  int bits = BigBits(big);
+  if (bits < 128) {
+    BigShiftLeft(big, 128 - bits);
+  } else {
+    BigShiftRight(big, bits - 128);
+  }
+}
+
+void BigShiftLeft(Big* big, int bits) {
+  for (; bits > 0; --bits) {
+    for (int i = BIG_LIMBS - 1; i > 0; --i) {
+      big->limbs[i] = big->limbs[i] << 1 | big->limbs[i - 1] >> 31;
+    }
+    big->limbs[0] <<= 1;
+  }
+}
+
+void BigShiftRight(Big* big, int bits) {
+  for (; bits > 0; --bits) {
+    for (int i = 0; i < BIG_LIMBS - 1; ++i) {
+      big->limbs[i] = big->limbs[i] >> 1 | big->limbs[i + 1] << 31;
+    }
+    big->limbs[BIG_LIMBS - 1] >>= 1;
+  }
+}
+
+void BigSubtract(Big* big, const Big* other) {
+  uint64_t borrow = 0;
+  for (int i = 0; i < BIG_LIMBS; ++i) {
+    uint64_t difference =
+        (uint64_t)big->limbs[i] - other->limbs[i] - borrow;
+    big->limbs[i] = (uint32_t)difference;
+    borrow = difference >> 63;
+  }
+}
+
+void BigIncrement(Big* big) {
+  for (int i = 0; i < BIG_LIMBS && ++big->limbs[i] == 0; ++i) {
+  }
+}
+
+int BigCompare(const Big* a, const Big* b) {
+  for (int i = BIG_LIMBS - 1; i >= 0; --i) {
+    if (a->limbs[i] != b->limbs[i]) {
+      return a->limbs[i] < b->limbs[i] ? -1 : 1;
+    }
+  }
+  return 0;
+}
+
+int BigBits(const Big* big) {
+  for (int i = BIG_LIMBS - 1; i >= 0; --i) {
+    if (big->limbs[i] != 0) {
+      return i * 32 + 32 - __builtin_clz(big->limbs[i]);
+    }
+  }
+  return 0;
+}
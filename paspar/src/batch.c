@@ -0,0 +1,221 @@
+#include "batch.h"
+
+#include <arena/arena.h>
+#include <dirent.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <pas/lex.h>
+#include <pas/source.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "pool.h"
+#include "trace.h"
+
+// Workers run at most this many files per worker ahead of the one being
+// written, which bounds the output held in memory.
+#define BATCH_FILES_PER_JOB 4
+
+typedef struct {
+  String output;
+  int error;
+  // The step that failed with `error`, for the message.
+  const char* failed;
+  bool done;
+} BatchResult;
+
+typedef struct {
+  const BatchPaths* paths;
+  DumpFormat format;
+  BatchResult* results;
+  Arena* arenas;
+  pthread_mutex_t lock;
+  pthread_cond_t done;
+} Batch;
+
+static bool BatchWalk(BatchPaths* paths, const char* directory);
+static bool IsPascalFile(const char* name);
+static char* JoinPath(const char* directory, const char* name);
+static void BatchLexFile(void* context, uint64_t index, uint32_t worker);
+
+bool BatchCollect(BatchPaths* paths, const char* path) {
+  struct stat st;
+  if (strcmp(path, "-") != 0 && stat(path, &st) == 0 && S_ISDIR(st.st_mode)) {
+    return BatchWalk(paths, path);
+  }
+  char* copy = strdup(path);
+  return copy != NULL && VEC_PUSH(paths, copy);
+}
+
+void BatchPathsFree(BatchPaths* paths) {
+  for (uint64_t i = 0; i < paths->size; ++i) {
+    free(paths->data[i]);
+  }
+  VEC_FREE(paths);
+}
+
+bool BatchRun(const BatchPaths* paths, uint32_t jobs, DumpFormat format) {
+  Batch batch = {
+      .paths = paths,
+      .format = format,
+      .results = calloc(paths->size, sizeof(BatchResult)),
+      .arenas = calloc(jobs, sizeof(Arena)),
+  };
+  if (batch.results == NULL || batch.arenas == NULL) {
+    free(batch.results);
+    free(batch.arenas);
+    fprintf(stderr, "Out of memory\n");
+    return false;
+  }
+  for (uint32_t i = 0; i < jobs; ++i) {
+    ArenaInit(&batch.arenas[i], 0);
+  }
+  pthread_mutex_init(&batch.lock, NULL);
+  pthread_cond_init(&batch.done, NULL);
+  DumpOutput output;
+  DumpInit(&output, STDOUT_FILENO, format);
+  Pool pool;
+  bool started = PoolStart(&pool, jobs, paths->size,
+                           (uint64_t)jobs * BATCH_FILES_PER_JOB, BatchLexFile,
+                           &batch);
+  bool result = started;
+  for (uint64_t i = 0; started && i < paths->size; ++i) {
+    BatchResult* file = &batch.results[i];
+    TraceSpan wait = TraceBegin("wait", paths->data[i]);
+    pthread_mutex_lock(&batch.lock);
+    while (!file->done) {
+      pthread_cond_wait(&batch.done, &batch.lock);
+    }
+    pthread_mutex_unlock(&batch.lock);
+    TraceEnd(&wait);
+    if (file->error != 0) {
+      DumpFlush(&output);
+      fprintf(stderr, "Could not %s %s: %s\n", file->failed, paths->data[i],
+              strerror(file->error));
+      result = false;
+    } else {
+      DumpWrite(&output, file->output.data, file->output.size);
+    }
+    VEC_FREE(&file->output);
+    PoolAdvance(&pool, i + 1);
+  }
+  if (started) {
+    PoolJoin(&pool);
+  } else {
+    fprintf(stderr, "Could not start workers\n");
+  }
+  if (!DumpFinish(&output)) {
+    fprintf(stderr, "Could not write output: %s\n", strerror(output.error));
+    result = false;
+  }
+  pthread_cond_destroy(&batch.done);
+  pthread_mutex_destroy(&batch.lock);
+  for (uint32_t i = 0; i < jobs; ++i) {
+    ArenaFree(&batch.arenas[i]);
+  }
+  free(batch.arenas);
+  free(batch.results);
+  return result;
+}
+
+void BatchLexFile(void* context, uint64_t index, uint32_t worker) {
+  Batch* batch = context;
+  BatchResult* result = &batch->results[index];
+  const char* path = batch->paths->data[index];
+  char thread_name[32];
+  snprintf(thread_name, sizeof(thread_name), "worker %" PRIu32, worker);
+  TraceThreadName(thread_name);
+  TraceSpan file_span = TraceBegin("file", path);
+  TraceSpan span = TraceBegin("read", path);
+  PasSource source;
+  bool opened = PasSourceOpen(&source, path);
+  TraceEnd(&span);
+  if (opened) {
+    Arena* arena = &batch->arenas[worker];
+    ArenaMark mark = ArenaGetMark(arena);
+    span = TraceBegin("lex", path);
+    PasTokenStream tokens = PasLexWithOptions(
+        &source, &(PasLexOptions){.allocator = ArenaVecAllocator(arena)});
+    TraceEnd(&span);
+    if (tokens.error == 0) {
+      span = TraceBegin("format", path);
+      StringView view = PasSourceView(&source);
+      uint64_t previous_end = 0;
+      DumpAppendFileStart(&result->output, batch->format, path);
+      for (uint64_t i = 0; i < PasTokenStreamSize(&tokens); ++i) {
+        PasToken token = PasTokenStreamGet(&tokens, i);
+        DumpAppendToken(&result->output, batch->format, &token, view,
+                        &previous_end);
+      }
+      DumpAppendFileEnd(&result->output, batch->format);
+      TraceEnd(&span);
+    } else {
+      result->error = tokens.error;
+      result->failed = "lex";
+    }
+    ArenaRelease(arena, mark);
+    PasSourceClose(&source);
+  } else {
+    result->error = errno;
+    result->failed = "open";
+  }
+  TraceEnd(&file_span);
+  pthread_mutex_lock(&batch->lock);
+  result->done = true;
+  pthread_cond_broadcast(&batch->done);
+  pthread_mutex_unlock(&batch->lock);
+}
+
+bool BatchWalk(BatchPaths* paths, const char* directory) {
+  struct dirent** entries;
+  int count = scandir(directory, &entries, NULL, alphasort);
+  if (count < 0) {
+    fprintf(stderr, "Could not read %s: %s\n", directory, strerror(errno));
+    return false;
+  }
+  bool result = true;
+  for (int i = 0; i < count; ++i) {
+    const char* name = entries[i]->d_name;
+    if (result && strcmp(name, ".") != 0 && strcmp(name, "..") != 0) {
+      char* path = JoinPath(directory, name);
+      struct stat st;
+      if (path == NULL) {
+        result = false;
+      } else if (stat(path, &st) == 0 && S_ISDIR(st.st_mode)) {
+        result = BatchWalk(paths, path);
+        free(path);
+      } else if (IsPascalFile(name)) {
+        result = VEC_PUSH(paths, path);
+      } else {
+        free(path);
+      }
+    }
+    free(entries[i]);
+  }
+  free(entries);
+  return result;
+}
+
+bool IsPascalFile(const char* name) {
+  size_t length = strlen(name);
+  return length > 4 && strcasecmp(name + length - 4, ".pas") == 0;
+}
+
+char* JoinPath(const char* directory, const char* name) {
+  size_t directory_length = strlen(directory);
+  size_t name_length = strlen(name);
+  bool slash = directory_length > 0 && directory[directory_length - 1] == '/';
+  char* path = malloc(directory_length + !slash + name_length + 1);
+  if (path != NULL) {
+    memcpy(path, directory, directory_length);
+    if (!slash) {
+      path[directory_length] = '/';
+    }
+    memcpy(path + directory_length + !slash, name, name_length + 1);
+  }
+  return path;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <vec/vec.h>
+
+#include "dump.h"
+
+typedef VEC_TYPE(char*) BatchPaths;
+
+// Adds `path` to `paths`; directories are walked recursively in sorted order
+// for files ending in ".pas".
+bool BatchCollect(BatchPaths* paths, const char* path);
+void BatchPathsFree(BatchPaths* paths);
+
+// Lexes every path on `jobs` workers and prints each file's tokens in the
+// order of `paths`. Returns false if any file failed.
+bool BatchRun(const BatchPaths* paths, uint32_t jobs, DumpFormat format);
@@ -0,0 +1,301 @@
+#include "dump.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+
+#include "trace.h"
+
+#define DUMP_NAME_WIDTH 20
+
+// Longest output of DumpAppendToken besides the token text, and the most an
+// escaped byte of it can take.
+#define DUMP_TOKEN_OVERHEAD 128
+#define DUMP_JSON_ESCAPE_MAX 6
+// Tokens up to this long are copied as a whole block, reading into the
+// source padding.
+#define DUMP_SHORT_TOKEN 16
+
+// Each type name as the text format prints it, right-aligned in
+// DUMP_NAME_WIDTH columns and followed by ": ", and as the start of a JSON
+// line up to the position's value.
+typedef struct {
+  char text[DUMP_NAME_WIDTH + 16];
+  char json[48];
+  uint8_t text_length;
+  uint8_t json_length;
+} DumpName;
+
+static const char* const kDumpFormatNames[] = {
+#define X(x) #x,
+    DUMP_FORMAT_VARIANTS_
+#undef X
+};
+
+_Static_assert(kPasTokenTypeCount <= DUMP_BINARY_END,
+               "a token type would read as the end of a file");
+
+static DumpName dump_names[kPasTokenTypeCount];
+static pthread_once_t dump_names_once = PTHREAD_ONCE_INIT;
+
+static void DumpInitNames(void);
+static void DumpWriteAll(DumpOutput* output, const char* data, uint64_t size);
+static char* AppendSpace(String* out, uint64_t size);
+static char* WriteJsonString(char* p, StringView text);
+static char* WriteDecimal(char* p, uint64_t value);
+static char* WriteLeb128(char* p, uint64_t value);
+
+bool DumpParseFormat(const char* text, DumpFormat* format) {
+  for (uint32_t i = 0; i < sizeof(kDumpFormatNames) / sizeof(char*); ++i) {
+    if (strcasecmp(text, kDumpFormatNames[i]) == 0) {
+      *format = (DumpFormat)i;
+      return true;
+    }
+  }
+  return false;
+}
+
+void DumpAppendFileStart(String* out, DumpFormat format, const char* path) {
+  pthread_once(&dump_names_once, DumpInitNames);
+  StringView view = StringViewMake(path, strlen(path));
+  char* p = AppendSpace(out, DUMP_TOKEN_OVERHEAD +
+                                 view.size * DUMP_JSON_ESCAPE_MAX);
+  if (p == NULL) {
+    return;
+  }
+  char* end = p;
+  switch (format) {
+    case kDumpFormatText:
+      memcpy(end, view.data, view.size);
+      end += view.size;
+      *end++ = ':';
+      *end++ = '\n';
+      break;
+    case kDumpFormatJsonl:
+      memcpy(end, "{\"file\":", 8);
+      end = WriteJsonString(end + 8, view);
+      *end++ = '}';
+      *end++ = '\n';
+      break;
+    case kDumpFormatBinary:
+      end = WriteLeb128(end, view.size);
+      memcpy(end, view.data, view.size);
+      end += view.size;
+      break;
+  }
+  out->size = (uint64_t)(end - out->data);
+}
+
+// Reserves room for the longest form of the token, then gives back what was
+// not used, so each token costs one capacity check.
+void DumpAppendToken(String* out,
+                     DumpFormat format,
+                     const PasToken* token,
+                     StringView text,
+                     uint64_t* previous_end) {
+  DumpAppendTokenText(out, format, token, PasTokenText(text, token),
+                      previous_end);
+}
+
+void DumpAppendTokenText(String* out,
+                         DumpFormat format,
+                         const PasToken* token,
+                         StringView token_text,
+                         uint64_t* previous_end) {
+  const DumpName* name = &dump_names[token->type];
+  uint64_t escaped = format == kDumpFormatJsonl
+                         ? token_text.size * DUMP_JSON_ESCAPE_MAX
+                         : token_text.size;
+  char* p = AppendSpace(out, DUMP_TOKEN_OVERHEAD + escaped);
+  if (p == NULL) {
+    return;
+  }
+  char* end = p;
+  switch (format) {
+    case kDumpFormatText:
+      // Fixed-size copies compile to a few moves; the slack past the end is
+      // overwritten or given back.
+      memcpy(end, name->text, sizeof(name->text));
+      end += name->text_length;
+      if (token_text.size <= DUMP_SHORT_TOKEN) {
+        memcpy(end, token_text.data, DUMP_SHORT_TOKEN);
+      } else {
+        memcpy(end, token_text.data, token_text.size);
+      }
+      end += token_text.size;
+      *end++ = '\n';
+      break;
+    case kDumpFormatJsonl:
+      memcpy(end, name->json, name->json_length);
+      end = WriteDecimal(end + name->json_length, token->position);
+      memcpy(end, ",\"length\":", 10);
+      end = WriteDecimal(end + 10, token->length);
+      memcpy(end, ",\"text\":", 8);
+      end = WriteJsonString(end + 8, token_text);
+      *end++ = '}';
+      *end++ = '\n';
+      break;
+    case kDumpFormatBinary:
+      *end++ = (char)token->type;
+      end = WriteLeb128(end, token->position - *previous_end);
+      end = WriteLeb128(end, token->length);
+      break;
+  }
+  out->size = (uint64_t)(end - out->data);
+  *previous_end = token->position + token->length;
+}
+
+void DumpAppendFileEnd(String* out, DumpFormat format) {
+  if (format == kDumpFormatBinary) {
+    VEC_PUSH(out, (char)DUMP_BINARY_END);
+  }
+}
+
+void DumpInit(DumpOutput* output, int fd, DumpFormat format) {
+  pthread_once(&dump_names_once, DumpInitNames);
+  *output = (DumpOutput){.fd = fd, .format = format};
+  VEC_RESERVE(&output->buffer, DUMP_BUFFER_SIZE);
+  if (format == kDumpFormatBinary) {
+    VEC_APPEND(&output->buffer, DUMP_BINARY_MAGIC,
+               sizeof(DUMP_BINARY_MAGIC) - 1);
+  }
+}
+
+void DumpWrite(DumpOutput* output, const char* data, uint64_t size) {
+  if (output->buffer.size + size <= DUMP_BUFFER_SIZE) {
+    VEC_APPEND(&output->buffer, data, size);
+    return;
+  }
+  DumpFlush(output);
+  // Large blocks, such as a whole file in batch mode, skip the copy.
+  DumpWriteAll(output, data, size);
+}
+
+void DumpMaybeFlush(DumpOutput* output) {
+  if (output->buffer.size >= DUMP_BUFFER_SIZE) {
+    DumpFlush(output);
+  }
+}
+
+void DumpFlush(DumpOutput* output) {
+  DumpWriteAll(output, output->buffer.data, output->buffer.size);
+  output->buffer.size = 0;
+}
+
+bool DumpFinish(DumpOutput* output) {
+  DumpFlush(output);
+  VEC_FREE(&output->buffer);
+  return output->error == 0;
+}
+
+void DumpInitNames(void) {
+  for (uint32_t i = 0; i < kPasTokenTypeCount; ++i) {
+    const char* name = kPasTokenTypeNames[i];
+    size_t length = strlen(name);
+    size_t padding = length < DUMP_NAME_WIDTH ? DUMP_NAME_WIDTH - length : 0;
+    DumpName* out = &dump_names[i];
+    memset(out->text, ' ', padding);
+    memcpy(out->text + padding, name, length);
+    memcpy(out->text + padding + length, ": ", 2);
+    out->text_length = (uint8_t)(padding + length + 2);
+    int json = snprintf(out->json, sizeof(out->json),
+                        "{\"type\":\"%s\",\"position\":", name);
+    out->json_length = (uint8_t)json;
+  }
+}
+
+void DumpWriteAll(DumpOutput* output, const char* data, uint64_t size) {
+  if (size == 0) {
+    return;
+  }
+  TraceSpan span = TraceBegin("write", NULL);
+  while (size > 0 && output->error == 0) {
+    ssize_t n = write(output->fd, data, size);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0) {
+      output->error = errno;
+      break;
+    }
+    data += n;
+    size -= (uint64_t)n;
+  }
+  TraceEnd(&span);
+}
+
+// Makes room for `size` more bytes and returns where they start, or NULL if
+// out of memory. The caller sets the new size.
+char* AppendSpace(String* out, uint64_t size) {
+  uint64_t needed = out->size + size;
+  if (needed > out->capacity) {
+    uint64_t grown = out->capacity * 2;
+    if (!VEC_RESERVE(out, grown > needed ? grown : needed)) {
+      return NULL;
+    }
+  }
+  return out->data + out->size;
+}
+
+// Source text has no known encoding, so each byte from 0x80 up is escaped as
+// the code point of the same value, which keeps the output valid UTF-8.
+char* WriteJsonString(char* p, StringView text) {
+  static const char kHex[] = "0123456789abcdef";
+  *p++ = '"';
+  for (uint64_t i = 0; i < text.size; ++i) {
+    unsigned char c = (unsigned char)text.data[i];
+    if (c >= 0x20 && c < 0x80 && c != '"' && c != '\\') {
+      *p++ = (char)c;
+      continue;
+    }
+    *p++ = '\\';
+    switch (c) {
+      case '"':
+      case '\\':
+        *p++ = (char)c;
+        break;
+      case '\n':
+        *p++ = 'n';
+        break;
+      case '\r':
+        *p++ = 'r';
+        break;
+      case '\t':
+        *p++ = 't';
+        break;
+      default:
+        memcpy(p, "u00", 3);
+        p[3] = kHex[c >> 4];
+        p[4] = kHex[c & 15];
+        p += 5;
+        break;
+    }
+  }
+  *p++ = '"';
+  return p;
+}
+
+char* WriteDecimal(char* p, uint64_t value) {
+  char digits[20];
+  int count = 0;
+  do {
+    digits[sizeof(digits) - 1 - count++] = (char)('0' + value % 10);
+    value /= 10;
+  } while (value != 0);
+  memcpy(p, digits + sizeof(digits) - count, (size_t)count);
+  return p + count;
+}
+
+char* WriteLeb128(char* p, uint64_t value) {
+  while (value >= 0x80) {
+    *p++ = (char)(value | 0x80);
+    value >>= 7;
+  }
+  *p++ = (char)value;
+  return p;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <pas/lex.h>
+#include <pas/string.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// Output is gathered into a buffer of this size before each write.
+#define DUMP_BUFFER_SIZE (1024 * 1024)
+
+#define DUMP_FORMAT_VARIANTS_ \
+  X(Text)                     \
+  X(Jsonl)                    \
+  X(Binary)
+
+typedef enum {
+#define X(x) kDumpFormat##x,
+  DUMP_FORMAT_VARIANTS_
+#undef X
+} DumpFormat;
+
+// Text is the "%20s: %s" listing, with a "path:" line before each file in
+// batch mode. Jsonl writes a {"file": ...} object per file and a {"type",
+// "position", "length", "text"} object per token, where each byte of the
+// text from 0x80 up is written as \u00XX. Binary starts with
+// DUMP_BINARY_MAGIC; each file is a LEB128 path length and the path, then
+// per token its type byte and the LEB128 gap since the previous token's end
+// and length, ending with a DUMP_BINARY_END byte. Zero is a valid type, as
+// the lexer gives it to bytes such as '#' that start no other token.
+#define DUMP_BINARY_MAGIC "PASDUMP\x02"
+#define DUMP_BINARY_END 0xFF
+
+typedef struct {
+  int fd;
+  DumpFormat format;
+  String buffer;
+  // The errno of the first failed write; later output is dropped.
+  int error;
+} DumpOutput;
+
+bool DumpParseFormat(const char* text, DumpFormat* format);
+
+// Appends a file's header, tokens and trailer to `out`. `text` must be the
+// view of a PasSource, whose padding may be read. `previous_end` is 0 at the
+// start of each file.
+void DumpAppendFileStart(String* out, DumpFormat format, const char* path);
+void DumpAppendToken(String* out,
+                     DumpFormat format,
+                     const PasToken* token,
+                     StringView text,
+                     uint64_t* previous_end);
+// Takes the token's own text, which must also be followed by padding, for
+// callers that do not hold the whole source.
+void DumpAppendTokenText(String* out,
+                         DumpFormat format,
+                         const PasToken* token,
+                         StringView token_text,
+                         uint64_t* previous_end);
+void DumpAppendFileEnd(String* out, DumpFormat format);
+
+void DumpInit(DumpOutput* output, int fd, DumpFormat format);
+// Writes `size` bytes to the output, after anything already buffered.
+void DumpWrite(DumpOutput* output, const char* data, uint64_t size);
+// Writes the buffer out once it holds DUMP_BUFFER_SIZE bytes.
+void DumpMaybeFlush(DumpOutput* output);
+void DumpFlush(DumpOutput* output);
+// Flushes and frees the buffer. Returns false if any write failed.
+bool DumpFinish(DumpOutput* output);
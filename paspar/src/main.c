@@ -1,30 +1,439 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
 #include <pas/lex.h>
+#include <pas/lex_stream.h>
+#include <pas/lines.h>
+#include <pas/parse.h>
+#include <pas/source.h>
+#include <pas/stats.h>
+#include <pas/token_file.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
-int main(void) {
-  String source = {0};
-  FILE* fp = fopen("test.pas", "r");
-  if (!fp) {
-    fprintf(stderr, "Could not open test.pas\n");
+#include "batch.h"
+#include "dump.h"
+#include "report.h"
+#include "trace.h"
+
+static bool LexFile(const char* path, DumpFormat format);
+static bool ReadFile(PasSource* source, const char* path);
+static bool LexStream(const char* path, uint64_t chunk_size, DumpFormat format);
+static bool LexFileCached(const char* path,
+                          const char* save_path,
+                          const char* load_path,
+                          DumpFormat format);
+static void DumpStart(DumpOutput* output, DumpFormat format, const char* path);
+static bool DumpEnd(DumpOutput* output);
+static bool ParseFile(const char* path);
+static void PrintNode(const PasAst* ast,
+                      const PasTokenStream* tokens,
+                      StringView text,
+                      uint32_t index,
+                      int depth);
+static bool LexBatch(char** paths, int count, uint32_t jobs, DumpFormat format);
+static bool ParseJobs(const char* text, uint32_t* jobs);
+static bool ParseChunkSize(const char* text, uint64_t* chunk_size);
+static bool IsDirectory(const char* path);
+static void Usage(const char* program);
+
+int main(int argc, char** argv) {
+  uint32_t jobs = 0;
+  bool batch = false;
+  bool ast = false;
+  const char* save_path = NULL;
+  const char* load_path = NULL;
+  DumpFormat format = kDumpFormatText;
+  bool stats = false;
+  bool stats_json = false;
+  const char* trace_path = NULL;
+  bool stream = false;
+  uint64_t chunk_size = 0;
+  int i = 1;
+  for (; i < argc && argv[i][0] == '-' && argv[i][1] != '\0'; ++i) {
+    if (strcmp(argv[i], "--") == 0) {
+      ++i;
+      break;
+    }
+    if (strcmp(argv[i], "--ast") == 0) {
+      ast = true;
+      continue;
+    }
+    if (strncmp(argv[i], "--format=", 9) == 0 ||
+        (strcmp(argv[i], "--format") == 0 && i + 1 < argc)) {
+      const char* name = argv[i][8] == '=' ? argv[i] + 9 : argv[++i];
+      if (!DumpParseFormat(name, &format)) {
+        Usage(argv[0]);
+        return 1;
+      }
+      continue;
+    }
+    if (strcmp(argv[i], "--stats") == 0 ||
+        strcmp(argv[i], "--stats=table") == 0 ||
+        strcmp(argv[i], "--stats=json") == 0) {
+      stats = true;
+      stats_json = strcmp(argv[i], "--stats=json") == 0;
+      continue;
+    }
+    if (strcmp(argv[i], "--stream") == 0 ||
+        strncmp(argv[i], "--stream=", 9) == 0) {
+      stream = true;
+      if (argv[i][8] == '=' && !ParseChunkSize(argv[i] + 9, &chunk_size)) {
+        Usage(argv[0]);
+        return 1;
+      }
+      continue;
+    }
+    if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+      trace_path = argv[++i];
+      continue;
+    }
+    if (strcmp(argv[i], "--save-tokens") == 0 && i + 1 < argc) {
+      save_path = argv[++i];
+      continue;
+    }
+    if (strcmp(argv[i], "--load-tokens") == 0 && i + 1 < argc) {
+      load_path = argv[++i];
+      continue;
+    }
+    if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+      if (!ParseJobs(argv[++i], &jobs)) {
+        Usage(argv[0]);
+        return 1;
+      }
+    } else if (strncmp(argv[i], "--jobs=", 7) == 0) {
+      if (!ParseJobs(argv[i] + 7, &jobs)) {
+        Usage(argv[0]);
+        return 1;
+      }
+    } else {
+      Usage(argv[0]);
+      return 1;
+    }
+    batch = true;
+  }
+  bool cached = save_path != NULL || load_path != NULL;
+  if (i == argc || ((ast || cached || stream) && (batch || argc - i != 1)) ||
+      ast + cached + stream > 1 || (save_path != NULL && load_path != NULL)) {
+    Usage(argv[0]);
     return 1;
   }
-  char buf[1024];
-  while (fgets(buf, sizeof(buf), fp) != NULL) {
-    VEC_APPEND(&source, buf, strlen(buf));
+  if (stats && !PasLexStatsGet(&(PasLexStats){0})) {
+    fprintf(stderr, "--stats needs a build configured with -DPAS_STATS=ON\n");
+    return 1;
+  }
+  if (trace_path != NULL) {
+    TraceStart(trace_path);
+  }
+  bool result;
+  if (ast) {
+    result = ParseFile(argv[i]);
+  } else if (cached) {
+    result = LexFileCached(argv[i], save_path, load_path, format);
+  } else if (stream) {
+    result = LexStream(argv[i], chunk_size, format);
+  } else if (!batch && argc - i == 1 && !IsDirectory(argv[i])) {
+    result = LexFile(argv[i], format);
+  } else {
+    result = LexBatch(argv + i, argc - i, jobs, format);
+  }
+  if (stats) {
+    PasLexStats totals;
+    PasLexStatsGet(&totals);
+    ReportStats(stderr, &totals, stats_json);
+  }
+  if (!TraceFinish()) {
+    fprintf(stderr, "Could not write %s: %s\n", trace_path, strerror(errno));
+    result = false;
+  }
+  return result ? 0 : 1;
+}
+
+// Lexing and formatting interleave here, so they share one span; the writes
+// of full buffers show up inside it.
+bool LexFile(const char* path, DumpFormat format) {
+  PasSource source;
+  if (!ReadFile(&source, path)) {
+    return false;
+  }
+  StringView text = PasSourceView(&source);
+  DumpOutput output;
+  DumpStart(&output, format, path);
+  TraceSpan span = TraceBegin("lex+format", path);
+  PasLexer lexer;
+  PasLexerInit(&lexer, &source);
+  PasToken token;
+  uint64_t previous_end = 0;
+  while (PasLexerNext(&lexer, &token)) {
+    DumpAppendToken(&output.buffer, format, &token, text, &previous_end);
+    DumpMaybeFlush(&output);
+  }
+  PasLexerFinish(&lexer);
+  TraceEnd(&span);
+  PasSourceClose(&source);
+  return DumpEnd(&output);
+}
+
+bool ReadFile(PasSource* source, const char* path) {
+  TraceSpan span = TraceBegin("read", path);
+  bool result = PasSourceOpen(source, path);
+  TraceEnd(&span);
+  if (!result) {
+    fprintf(stderr, "Could not open %s: %s\n", path, strerror(errno));
+  }
+  return result;
+}
+
+// Lexes `path` a chunk at a time, so that output starts before the input
+// ends and memory does not grow with it.
+bool LexStream(const char* path, uint64_t chunk_size, DumpFormat format) {
+  int fd = strcmp(path, "-") == 0 ? STDIN_FILENO : open(path, O_RDONLY);
+  PasStreamLexer lexer;
+  if (fd < 0 || !PasStreamLexerInit(&lexer, fd, chunk_size)) {
+    fprintf(stderr, "Could not open %s: %s\n", path, strerror(errno));
+    if (fd > STDIN_FILENO) {
+      close(fd);
+    }
+    return false;
+  }
+  DumpOutput output;
+  DumpStart(&output, format, path);
+  TraceSpan span = TraceBegin("read+lex+format", path);
+  PasToken token;
+  StringView text;
+  uint64_t previous_end = 0;
+  while (PasStreamLexerNext(&lexer, &token, &text)) {
+    DumpAppendTokenText(&output.buffer, format, &token, text, &previous_end);
+    DumpMaybeFlush(&output);
+  }
+  TraceEnd(&span);
+  int error = lexer.error;
+  PasStreamLexerFinish(&lexer);
+  if (fd != STDIN_FILENO) {
+    close(fd);
+  }
+  if (error != 0) {
+    fprintf(stderr, "Could not read %s: %s\n", path, strerror(error));
+  }
+  return DumpEnd(&output) && error == 0;
+}
+
+// Lexes `path` and saves its tokens to `save_path`, or takes them from
+// `load_path` without lexing, then prints them like LexFile.
+bool LexFileCached(const char* path,
+                   const char* save_path,
+                   const char* load_path,
+                   DumpFormat format) {
+  PasSource source;
+  if (!ReadFile(&source, path)) {
+    return false;
+  }
+  StringView text = PasSourceView(&source);
+  PasTokenFile file = {0};
+  PasTokenStream lexed = {0};
+  const PasTokenStream* tokens = NULL;
+  if (load_path != NULL) {
+    TraceSpan span = TraceBegin("load", load_path);
+    bool loaded = PasTokenFileOpen(&file, load_path, text);
+    TraceEnd(&span);
+    if (loaded) {
+      tokens = &file.tokens;
+    } else {
+      fprintf(stderr, "Could not load %s: %s\n", load_path,
+              errno == ESTALE ? "written for a different source"
+                              : strerror(errno));
+    }
+  } else {
+    TraceSpan span = TraceBegin("lex", path);
+    lexed = PasLex(&source);
+    TraceEnd(&span);
+    if (lexed.error != 0) {
+      fprintf(stderr, "Could not lex %s: %s\n", path, strerror(lexed.error));
+    } else {
+      span = TraceBegin("save", save_path);
+      bool saved = PasTokenFileWrite(save_path, &lexed, text);
+      TraceEnd(&span);
+      if (saved) {
+        tokens = &lexed;
+      } else {
+        fprintf(stderr, "Could not save %s: %s\n", save_path,
+                strerror(errno));
+      }
+    }
+  }
+  bool ok = tokens != NULL;
+  if (ok) {
+    DumpOutput output;
+    DumpStart(&output, format, path);
+    TraceSpan span = TraceBegin("format", path);
+    uint64_t previous_end = 0;
+    for (uint64_t i = 0; i < PasTokenStreamSize(tokens); ++i) {
+      PasToken token = PasTokenStreamGet(tokens, i);
+      DumpAppendToken(&output.buffer, format, &token, text, &previous_end);
+      DumpMaybeFlush(&output);
+    }
+    TraceEnd(&span);
+    ok = DumpEnd(&output);
+  }
+  PasTokenFileClose(&file);
+  PasTokenStreamFree(&lexed);
+  PasSourceClose(&source);
+  return ok;
+}
+
+// A single file's text listing has no "path:" line, as in earlier versions.
+void DumpStart(DumpOutput* output, DumpFormat format, const char* path) {
+  DumpInit(output, STDOUT_FILENO, format);
+  if (format != kDumpFormatText) {
+    DumpAppendFileStart(&output->buffer, format, path);
+  }
+}
+
+bool DumpEnd(DumpOutput* output) {
+  DumpAppendFileEnd(&output->buffer, output->format);
+  if (!DumpFinish(output)) {
+    fprintf(stderr, "Could not write output: %s\n", strerror(output->error));
+    return false;
+  }
+  return true;
+}
+
+bool ParseFile(const char* path) {
+  PasSource source;
+  if (!ReadFile(&source, path)) {
+    return false;
+  }
+  StringView text = PasSourceView(&source);
+  TraceSpan span = TraceBegin("lex", path);
+  PasTokenStream tokens = PasLexWithOptions(
+      &source, &(PasLexOptions){.trivia = kPasTriviaDrop});
+  TraceEnd(&span);
+  if (tokens.error != 0) {
+    fprintf(stderr, "Could not lex %s: %s\n", path, strerror(tokens.error));
+    PasTokenStreamFree(&tokens);
+    PasSourceClose(&source);
+    return false;
   }
-  fclose(fp);
-  PasTokens tokens = PasLex(source);
-  VEC_FREE(&source);
-  for (uint64_t i = 0; i < tokens.size; ++i) {
-    printf("%20s: %.*s\n", kPasTokenTypeNames[tokens.data[i].type],
-           (int)tokens.data[i].text.size, tokens.data[i].text.data);
+  span = TraceBegin("parse", path);
+  PasAst ast;
+  PasParseError error;
+  bool ok = PasParse(&tokens, text, NULL, &ast, &error);
+  TraceEnd(&span);
+  if (ok) {
+    span = TraceBegin("print", path);
+    PrintNode(&ast, &tokens, text, ast.root, 0);
+    TraceEnd(&span);
+    PasAstFree(&ast);
+  } else {
+    PasLineTable lines;
+    uint64_t line = 0;
+    uint64_t column = 0;
+    if (PasLineTableBuild(&lines, text)) {
+      PasLineTableLookup(&lines, error.position, &line, &column);
+      PasLineTableFree(&lines);
+    }
+    fprintf(stderr, "%s:%" PRIu64 ":%" PRIu64 ": %s", path, line, column,
+            error.message);
+    if (error.expected != kPasTokenTypeZero) {
+      fprintf(stderr, " %s", kPasTokenTypeNames[error.expected]);
+    }
+    fprintf(stderr, "\n");
   }
-  for (uint64_t i = 0; i < tokens.size; ++i) {
-    VEC_FREE(&tokens.data[i].text);
+  PasTokenStreamFree(&tokens);
+  PasSourceClose(&source);
+  return ok;
+}
+
+void PrintNode(const PasAst* ast,
+               const PasTokenStream* tokens,
+               StringView text,
+               uint32_t index,
+               int depth) {
+  const PasNode* node = &ast->nodes.data[index];
+  printf("%*s%s", depth * 2, "", kPasNodeKindNames[node->kind]);
+  if (node->op != kPasTokenTypeZero) {
+    printf(" %s", kPasTokenTypeNames[node->op]);
   }
-  VEC_FREE(&tokens);
-  return 0;
+  if (node->token != PAS_NO_TOKEN) {
+    PasToken token = PasTokenStreamGet(tokens, node->token);
+    StringView token_text = PasTokenText(text, &token);
+    printf(" %.*s", (int)token_text.size, token_text.data);
+  }
+  printf("\n");
+  const uint32_t* children = PasAstChildren(ast, node);
+  for (uint32_t i = 0; i < node->child_count; ++i) {
+    PrintNode(ast, tokens, text, children[i], depth + 1);
+  }
+}
+
+bool LexBatch(char** paths, int count, uint32_t jobs, DumpFormat format) {
+  BatchPaths collected = {0};
+  for (int i = 0; i < count; ++i) {
+    if (!BatchCollect(&collected, paths[i])) {
+      BatchPathsFree(&collected);
+      return false;
+    }
+  }
+  if (jobs == 0) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    jobs = cpus > 0 ? (uint32_t)cpus : 1;
+  }
+  bool result = BatchRun(&collected, jobs, format);
+  BatchPathsFree(&collected);
+  return result;
+}
+
+bool ParseJobs(const char* text, uint32_t* jobs) {
+  char* end;
+  unsigned long value = strtoul(text, &end, 10);
+  if (*text == '\0' || *end != '\0' || value == 0 || value > 1024) {
+    return false;
+  }
+  *jobs = (uint32_t)value;
+  return true;
+}
+
+bool ParseChunkSize(const char* text, uint64_t* chunk_size) {
+  char* end;
+  unsigned long long value = strtoull(text, &end, 10);
+  if (*text == '\0' || *end != '\0' || value == 0 || value > UINT32_MAX) {
+    return false;
+  }
+  *chunk_size = value;
+  return true;
+}
+
+bool IsDirectory(const char* path) {
+  struct stat st;
+  return strcmp(path, "-") != 0 && stat(path, &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+void Usage(const char* program) {
+  fprintf(stderr,
+          "usage: %s [-j JOBS] [--format FORMAT] [--stats] [--trace FILE] "
+          "PATH...\n",
+          program);
+  fprintf(stderr, "       %s --ast PATH\n", program);
+  fprintf(stderr,
+          "       %s [--format FORMAT] --save-tokens|--load-tokens FILE "
+          "PATH\n",
+          program);
+  fprintf(stderr, "       %s [--format FORMAT] --stream[=BYTES] PATH\n",
+          program);
+  fprintf(stderr, "Use - to read from standard input. Directories are ");
+  fprintf(stderr, "searched for .pas files.\n");
+  fprintf(stderr, "Several paths, a directory or -j lex in batch mode.\n");
+  fprintf(stderr, "FORMAT is text (the default), jsonl or binary.\n");
+  fprintf(stderr, "--stats[=table|json] reports lexer statistics on ");
+  fprintf(stderr, "standard error.\n");
+  fprintf(stderr, "--trace FILE writes a Chrome trace of each phase.\n");
+  fprintf(stderr, "--ast parses PATH and prints its syntax tree.\n");
+  fprintf(stderr, "--stream lexes PATH as it is read, BYTES at a time ");
+  fprintf(stderr, "(1 MiB by default), in bounded memory.\n");
+  fprintf(stderr, "--save-tokens writes the tokens of PATH to FILE; ");
+  fprintf(stderr, "--load-tokens reads them back instead of lexing.\n");
 }
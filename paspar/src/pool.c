@@ -0,0 +1,89 @@
+#include "pool.h"
+
+#include <stdlib.h>
+
+static void* PoolWorkerMain(void* arg);
+static bool PoolTake(Pool* pool, uint64_t* index);
+
+bool PoolStart(Pool* pool,
+               uint32_t worker_count,
+               uint64_t count,
+               uint64_t window,
+               PoolTask task,
+               void* context) {
+  *pool = (Pool){
+      .task = task,
+      .context = context,
+      .worker_count = worker_count == 0 ? 1 : worker_count,
+      .count = count,
+      .window = window == 0 ? 1 : window,
+  };
+  pool->limit = pool->window;
+  pool->workers = calloc(pool->worker_count, sizeof(PoolWorker));
+  if (pool->workers == NULL) {
+    return false;
+  }
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->advanced, NULL);
+  bool any_started = false;
+  for (uint32_t i = 0; i < pool->worker_count; ++i) {
+    pool->workers[i] = (PoolWorker){.pool = pool, .index = i};
+    pool->workers[i].started = pthread_create(&pool->workers[i].thread, NULL,
+                                              PoolWorkerMain,
+                                              &pool->workers[i]) == 0;
+    any_started = any_started || pool->workers[i].started;
+  }
+  // If no worker started, run everything here; nothing would advance the
+  // window until this returns, so lift it.
+  if (!any_started) {
+    pool->limit = count;
+    PoolWorkerMain(&pool->workers[0]);
+  }
+  return true;
+}
+
+void PoolAdvance(Pool* pool, uint64_t done) {
+  pthread_mutex_lock(&pool->lock);
+  if (done + pool->window > pool->limit) {
+    pool->limit = done + pool->window;
+    pthread_cond_broadcast(&pool->advanced);
+  }
+  pthread_mutex_unlock(&pool->lock);
+}
+
+void PoolJoin(Pool* pool) {
+  // Nobody consumes results any more, so let the workers finish.
+  PoolAdvance(pool, pool->count);
+  for (uint32_t i = 0; i < pool->worker_count; ++i) {
+    if (pool->workers[i].started) {
+      pthread_join(pool->workers[i].thread, NULL);
+    }
+  }
+  pthread_cond_destroy(&pool->advanced);
+  pthread_mutex_destroy(&pool->lock);
+  free(pool->workers);
+  *pool = (Pool){0};
+}
+
+void* PoolWorkerMain(void* arg) {
+  PoolWorker* worker = arg;
+  Pool* pool = worker->pool;
+  uint64_t index;
+  while (PoolTake(pool, &index)) {
+    pool->task(pool->context, index, worker->index);
+  }
+  return NULL;
+}
+
+bool PoolTake(Pool* pool, uint64_t* index) {
+  pthread_mutex_lock(&pool->lock);
+  while (pool->next < pool->count && pool->next >= pool->limit) {
+    pthread_cond_wait(&pool->advanced, &pool->lock);
+  }
+  bool taken = pool->next < pool->count;
+  if (taken) {
+    *index = pool->next++;
+  }
+  pthread_mutex_unlock(&pool->lock);
+  return taken;
+}
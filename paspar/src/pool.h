@@ -0,0 +1,46 @@
+#pragma once
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// Runs `task` for every index in [0, count) on a fixed set of workers. The
+// workers take indices in order from a shared counter, so results complete
+// roughly in index order, and never more than `window` past the last index
+// passed to PoolAdvance, so a consumer that handles results in order holds
+// at most `window` of them at once.
+
+typedef void (*PoolTask)(void* context, uint64_t index, uint32_t worker);
+
+typedef struct Pool Pool;
+
+typedef struct {
+  Pool* pool;
+  uint32_t index;
+  pthread_t thread;
+  bool started;
+} PoolWorker;
+
+struct Pool {
+  PoolTask task;
+  void* context;
+  uint32_t worker_count;
+  PoolWorker* workers;
+  pthread_mutex_t lock;
+  pthread_cond_t advanced;
+  uint64_t next;
+  uint64_t count;
+  uint64_t window;
+  // Workers wait rather than take an index at or past this.
+  uint64_t limit;
+};
+
+bool PoolStart(Pool* pool,
+               uint32_t worker_count,
+               uint64_t count,
+               uint64_t window,
+               PoolTask task,
+               void* context);
+// Tells the workers that every index before `done` has been consumed.
+void PoolAdvance(Pool* pool, uint64_t done);
+void PoolJoin(Pool* pool);
@@ -0,0 +1,79 @@
+#include "report.h"
+
+#include <inttypes.h>
+#include <pas/lex.h>
+#include <pas/stats.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+static void ReportTable(FILE* out, const PasLexStats* stats);
+static void ReportJson(FILE* out, const PasLexStats* stats);
+static double Ratio(uint64_t part, uint64_t whole);
+
+void ReportStats(FILE* out, const PasLexStats* stats, bool json) {
+  if (json) {
+    ReportJson(out, stats);
+  } else {
+    ReportTable(out, stats);
+  }
+}
+
+void ReportTable(FILE* out, const PasLexStats* stats) {
+  uint64_t total_ticks = 0;
+  for (int i = 0; i < kPasLexBranchCount; ++i) {
+    total_ticks += stats->branch_ticks[i];
+  }
+  fprintf(out, "%-12s %12s %14s %7s %10s\n", "branch", "tokens", "ticks",
+          "time%", "ticks/tok");
+  for (int i = 0; i < kPasLexBranchCount; ++i) {
+    uint64_t tokens = stats->branch_tokens[i];
+    fprintf(out, "%-12s %12" PRIu64 " %14" PRIu64 " %6.1f%% %10.1f\n",
+            kPasLexBranchNames[i], tokens, stats->branch_ticks[i],
+            100 * Ratio(stats->branch_ticks[i], total_ticks),
+            Ratio(stats->branch_ticks[i], tokens));
+  }
+  fprintf(out, "\n%-16s %12s %14s\n", "type", "tokens", "bytes");
+  for (int i = 0; i < kPasTokenTypeCount; ++i) {
+    if (stats->tokens[i] != 0) {
+      fprintf(out, "%-16s %12" PRIu64 " %14" PRIu64 "\n",
+              kPasTokenTypeNames[i], stats->tokens[i], stats->bytes[i]);
+    }
+  }
+  uint64_t lookups = stats->keyword_hits + stats->keyword_misses;
+  fprintf(out,
+          "\nkeyword lookups: %" PRIu64 " hits, %" PRIu64
+          " misses (%.1f%% hits)\n",
+          stats->keyword_hits, stats->keyword_misses,
+          100 * Ratio(stats->keyword_hits, lookups));
+  fprintf(out, "allocations: %" PRIu64 ", %" PRIu64 " bytes\n",
+          stats->allocations, stats->allocation_bytes);
+}
+
+void ReportJson(FILE* out, const PasLexStats* stats) {
+  fprintf(out, "{\"branches\":{");
+  for (int i = 0; i < kPasLexBranchCount; ++i) {
+    fprintf(out, "%s\"%s\":{\"tokens\":%" PRIu64 ",\"ticks\":%" PRIu64 "}",
+            i == 0 ? "" : ",", kPasLexBranchNames[i],
+            stats->branch_tokens[i], stats->branch_ticks[i]);
+  }
+  fprintf(out, "},\"types\":{");
+  bool first = true;
+  for (int i = 0; i < kPasTokenTypeCount; ++i) {
+    if (stats->tokens[i] != 0) {
+      fprintf(out, "%s\"%s\":{\"tokens\":%" PRIu64 ",\"bytes\":%" PRIu64 "}",
+              first ? "" : ",", kPasTokenTypeNames[i], stats->tokens[i],
+              stats->bytes[i]);
+      first = false;
+    }
+  }
+  fprintf(out,
+          "},\"keyword_hits\":%" PRIu64 ",\"keyword_misses\":%" PRIu64
+          ",\"allocations\":%" PRIu64 ",\"allocation_bytes\":%" PRIu64 "}\n",
+          stats->keyword_hits, stats->keyword_misses, stats->allocations,
+          stats->allocation_bytes);
+}
+
+double Ratio(uint64_t part, uint64_t whole) {
+  return whole == 0 ? 0.0 : (double)part / (double)whole;
+}
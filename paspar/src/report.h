@@ -0,0 +1,8 @@
+#pragma once
+
+#include <pas/stats.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+// Prints `stats` as aligned tables, or as one JSON object when `json` is set.
+void ReportStats(FILE* out, const PasLexStats* stats, bool json);
@@ -0,0 +1,152 @@
+#include "trace.h"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vec/vec.h>
+
+typedef struct {
+  const char* name;
+  char* file;
+  uint64_t start;
+  uint64_t duration;
+  uint32_t thread;
+  // Thread name events carry the name in `file`.
+  bool thread_name;
+} TraceEvent;
+
+typedef struct {
+  const char* path;
+  uint64_t origin;
+  VEC_TYPE(TraceEvent) events;
+  uint32_t thread_count;
+  pthread_mutex_t lock;
+} Trace;
+
+static Trace trace = {.lock = PTHREAD_MUTEX_INITIALIZER};
+static _Thread_local uint32_t trace_thread;
+static _Thread_local bool trace_thread_named;
+
+static void TraceRecord(TraceEvent* event);
+static void TraceWriteString(FILE* out, const char* text);
+static uint64_t TraceNow(void);
+
+void TraceStart(const char* path) {
+  trace.path = path;
+  trace.origin = TraceNow();
+  TraceThreadName("main");
+}
+
+void TraceThreadName(const char* name) {
+  if (trace.path == NULL || trace_thread_named) {
+    return;
+  }
+  trace_thread_named = true;
+  TraceRecord(&(TraceEvent){.file = strdup(name), .thread_name = true});
+}
+
+TraceSpan TraceBegin(const char* name, const char* file) {
+  if (trace.path == NULL) {
+    return (TraceSpan){0};
+  }
+  return (TraceSpan){.name = name, .file = file, .start = TraceNow()};
+}
+
+void TraceEnd(const TraceSpan* span) {
+  if (trace.path == NULL || span->name == NULL) {
+    return;
+  }
+  TraceEvent event = {
+      .name = span->name,
+      .file = span->file == NULL ? NULL : strdup(span->file),
+      .start = span->start - trace.origin,
+      .duration = TraceNow() - span->start,
+  };
+  TraceRecord(&event);
+}
+
+bool TraceFinish(void) {
+  if (trace.path == NULL) {
+    return true;
+  }
+  FILE* out = fopen(trace.path, "w");
+  if (out != NULL) {
+    fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  }
+  for (uint64_t i = 0; i < trace.events.size; ++i) {
+    TraceEvent* event = &trace.events.data[i];
+    if (out != NULL && event->thread_name) {
+      fprintf(out,
+              "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,"
+              "\"tid\":%" PRIu32 ",\"args\":{\"name\":",
+              i == 0 ? "" : ",\n", event->thread);
+      TraceWriteString(out, event->file == NULL ? "" : event->file);
+      fprintf(out, "}}");
+    } else if (out != NULL) {
+      fprintf(out,
+              "%s{\"ph\":\"X\",\"name\":\"%s\",\"pid\":1,\"tid\":%" PRIu32
+              ",\"ts\":%.3f,\"dur\":%.3f",
+              i == 0 ? "" : ",\n", event->name, event->thread,
+              (double)event->start / 1000, (double)event->duration / 1000);
+      if (event->file != NULL) {
+        fprintf(out, ",\"args\":{\"file\":");
+        TraceWriteString(out, event->file);
+        fprintf(out, "}");
+      }
+      fprintf(out, "}");
+    }
+    free(event->file);
+  }
+  VEC_FREE(&trace.events);
+  trace.path = NULL;
+  if (out == NULL) {
+    return false;
+  }
+  fprintf(out, "\n]}\n");
+  bool result = !ferror(out);
+  int saved_errno = errno;
+  if (fclose(out) != 0 && result) {
+    return false;
+  }
+  errno = saved_errno;
+  return result;
+}
+
+// Threads are numbered in the order they first record something.
+void TraceRecord(TraceEvent* event) {
+  pthread_mutex_lock(&trace.lock);
+  if (trace_thread == 0) {
+    trace_thread = ++trace.thread_count;
+  }
+  event->thread = trace_thread;
+  if (!VEC_PUSH(&trace.events, *event)) {
+    free(event->file);
+  }
+  pthread_mutex_unlock(&trace.lock);
+}
+
+void TraceWriteString(FILE* out, const char* text) {
+  fputc('"', out);
+  for (const char* p = text; *p != '\0'; ++p) {
+    if (*p == '"' || *p == '\\') {
+      fprintf(out, "\\%c", *p);
+    } else if ((unsigned char)*p < 0x20) {
+      fprintf(out, "\\u%04x", (unsigned char)*p);
+    } else {
+      fputc(*p, out);
+    }
+  }
+  fputc('"', out);
+}
+
+uint64_t TraceNow(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000 + (uint64_t)now.tv_nsec;
+}
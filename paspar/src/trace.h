@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Records spans as Chrome trace events ("ph": "X") for chrome://tracing and
+// Perfetto. Until TraceStart is called every function returns at once.
+
+typedef struct {
+  const char* name;
+  // Shown as the span's "file" argument; may be NULL.
+  const char* file;
+  uint64_t start;
+} TraceSpan;
+
+// Starts recording; the trace is written to `path` by TraceFinish.
+void TraceStart(const char* path);
+// Names the calling thread's track; only the first call counts.
+void TraceThreadName(const char* name);
+// `name` must be a string literal; `file` is copied.
+TraceSpan TraceBegin(const char* name, const char* file);
+void TraceEnd(const TraceSpan* span);
+// Writes the trace. Returns false and leaves errno set on failure.
+bool TraceFinish(void);
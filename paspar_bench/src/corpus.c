@@ -0,0 +1,226 @@
+#include "corpus.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+const char* const kCorpusMixNames[] = {
+#define X(x) #x,
+    CORPUS_MIX_VARIANTS_
+#undef X
+};
+
+typedef enum {
+  kLineComment,
+  kLineIdentifiers,
+  kLineNumbers,
+  kLineStrings,
+  kLineControl,
+  kLineKindCount,
+} LineKind;
+
+typedef struct {
+  uint32_t weights[kLineKindCount];
+  uint32_t max_depth;
+} MixProfile;
+
+static const MixProfile kProfiles[kCorpusMixCount] = {
+    [kCorpusMixMixed] = {{20, 30, 20, 15, 15}, 6},
+    [kCorpusMixComments] = {{80, 5, 5, 5, 5}, 4},
+    [kCorpusMixIdentifiers] = {{5, 80, 5, 5, 5}, 4},
+    [kCorpusMixNumbers] = {{5, 10, 75, 5, 5}, 4},
+    [kCorpusMixStrings] = {{5, 10, 5, 75, 5}, 4},
+    [kCorpusMixIndented] = {{20, 30, 20, 15, 15}, 40},
+};
+
+static const char* const kSyllables[] = {
+    "al", "be", "co", "da", "el", "fi", "go", "ha", "in", "jo", "ka", "lu",
+    "me", "no", "or", "pa", "qu", "ri", "su", "ti", "um", "ve", "wo", "xy",
+};
+
+static const char* const kWords[] = {
+    "the",   "lookahead", "character", "read", "new",    "from",
+    "input", "stream",    "report",    "an",   "error",  "and",
+    "halt",  "expected",  "recognize", "get",  "number", "output",
+};
+
+typedef struct {
+  String text;
+  uint64_t state;
+} Generator;
+
+static uint64_t Next(Generator* g);
+static uint32_t Below(Generator* g, uint32_t n);
+static void Emit(Generator* g, const char* text);
+static void EmitIdentifier(Generator* g);
+static void EmitNumber(Generator* g);
+static void EmitString(Generator* g);
+static void EmitWords(Generator* g, uint32_t count);
+static void EmitLine(Generator* g, LineKind kind, uint32_t depth);
+
+String CorpusGenerate(CorpusMix mix, uint64_t size, uint64_t seed) {
+  Generator g = {.state = seed};
+  VEC_RESERVE(&g.text, size + 256);
+  const MixProfile* profile = &kProfiles[mix];
+  uint32_t total = 0;
+  for (int i = 0; i < kLineKindCount; ++i) {
+    total += profile->weights[i];
+  }
+  Emit(&g, "program Bench;\nbegin\n");
+  uint32_t depth = 1;
+  while (g.text.size < size) {
+    uint32_t pick = Below(&g, total);
+    LineKind kind = kLineComment;
+    while (pick >= profile->weights[kind]) {
+      pick -= profile->weights[kind];
+      kind++;
+    }
+    if (kind == kLineControl && depth >= profile->max_depth) {
+      kind = kLineIdentifiers;
+    }
+    EmitLine(&g, kind, depth);
+    if (kind == kLineControl) {
+      depth++;
+    } else if (depth > 1 && Below(&g, 4) == 0) {
+      depth--;
+      EmitLine(&g, kLineKindCount, depth);
+    }
+  }
+  while (depth > 1) {
+    depth--;
+    EmitLine(&g, kLineKindCount, depth);
+  }
+  Emit(&g, "end.\n");
+  return g.text;
+}
+
+uint64_t Next(Generator* g) {
+  uint64_t z = (g->state += 0x9E3779B97F4A7C15ull);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+  return z ^ (z >> 31);
+}
+
+uint32_t Below(Generator* g, uint32_t n) {
+  return (uint32_t)(Next(g) % n);
+}
+
+void Emit(Generator* g, const char* text) {
+  VEC_APPEND(&g->text, text, strlen(text));
+}
+
+void EmitIdentifier(Generator* g) {
+  uint32_t syllables = 1 + Below(g, 4);
+  for (uint32_t i = 0; i < syllables; ++i) {
+    const char* s =
+        kSyllables[Below(g, sizeof(kSyllables) / sizeof(*kSyllables))];
+    VEC_PUSH(&g->text, i == 0 || Below(g, 3) == 0 ? (char)(s[0] - 'a' + 'A')
+                                                  : s[0]);
+    VEC_PUSH(&g->text, s[1]);
+  }
+  if (Below(g, 4) == 0) {
+    char digits[8];
+    snprintf(digits, sizeof(digits), "_%u", Below(g, 100));
+    Emit(g, digits);
+  }
+}
+
+void EmitNumber(Generator* g) {
+  char number[64];
+  switch (Below(g, 3)) {
+    case 0:
+      snprintf(number, sizeof(number), "%u", Below(g, 100000));
+      break;
+    case 1:
+      snprintf(number, sizeof(number), "%llu",
+               (unsigned long long)(Next(g) >> Below(g, 64)));
+      break;
+    default:
+      snprintf(number, sizeof(number), "%u.%ue%s%u", Below(g, 1000),
+               Below(g, 1000000), Below(g, 2) ? "-" : "+", Below(g, 300));
+      break;
+  }
+  Emit(g, number);
+}
+
+void EmitString(Generator* g) {
+  VEC_PUSH(&g->text, '\'');
+  uint32_t words = 1 + Below(g, 6);
+  for (uint32_t i = 0; i < words; ++i) {
+    if (i > 0) {
+      Emit(g, Below(g, 5) == 0 ? "''" : " ");
+    }
+    Emit(g, kWords[Below(g, sizeof(kWords) / sizeof(*kWords))]);
+  }
+  VEC_PUSH(&g->text, '\'');
+}
+
+void EmitWords(Generator* g, uint32_t count) {
+  for (uint32_t i = 0; i < count; ++i) {
+    VEC_PUSH(&g->text, ' ');
+    Emit(g, kWords[Below(g, sizeof(kWords) / sizeof(*kWords))]);
+  }
+}
+
+// kLineKindCount emits the `end;` closing a control line.
+void EmitLine(Generator* g, LineKind kind, uint32_t depth) {
+  for (uint32_t i = 0; i < depth; ++i) {
+    Emit(g, "   ");
+  }
+  switch (kind) {
+    case kLineComment:
+      if (Below(g, 3) == 0) {
+        Emit(g, "(*");
+        EmitWords(g, 4 + Below(g, 12));
+        Emit(g, "\n");
+        EmitWords(g, 4 + Below(g, 12));
+        Emit(g, " *)");
+      } else {
+        Emit(g, "{");
+        EmitWords(g, 2 + Below(g, 10));
+        Emit(g, " }");
+      }
+      break;
+    case kLineIdentifiers:
+      EmitIdentifier(g);
+      Emit(g, " := ");
+      EmitIdentifier(g);
+      for (uint32_t i = Below(g, 4); i > 0; --i) {
+        Emit(g, Below(g, 2) ? " + " : ".");
+        EmitIdentifier(g);
+      }
+      Emit(g, ";");
+      break;
+    case kLineNumbers:
+      EmitIdentifier(g);
+      Emit(g, " := ");
+      EmitNumber(g);
+      for (uint32_t i = Below(g, 4); i > 0; --i) {
+        Emit(g, Below(g, 2) ? " * " : " + ");
+        EmitNumber(g);
+      }
+      Emit(g, ";");
+      break;
+    case kLineStrings:
+      Emit(g, "WriteLn(");
+      EmitString(g);
+      for (uint32_t i = Below(g, 3); i > 0; --i) {
+        Emit(g, ", ");
+        EmitString(g);
+      }
+      Emit(g, ");");
+      break;
+    case kLineControl: {
+      bool is_if = Below(g, 2) == 0;
+      Emit(g, is_if ? "if not " : "while ");
+      EmitIdentifier(g);
+      Emit(g, " <= ");
+      EmitNumber(g);
+      Emit(g, is_if ? " then begin" : " do begin");
+    } break;
+    default:
+      Emit(g, "end;");
+      break;
+  }
+  Emit(g, "\n");
+}
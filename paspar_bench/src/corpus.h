@@ -0,0 +1,25 @@
+#pragma once
+
+#include <pas/string.h>
+#include <stdint.h>
+
+#define CORPUS_MIX_VARIANTS_ \
+  X(Mixed)                   \
+  X(Comments)                \
+  X(Identifiers)             \
+  X(Numbers)                 \
+  X(Strings)                 \
+  X(Indented)
+
+typedef enum {
+#define X(x) kCorpusMix##x,
+  CORPUS_MIX_VARIANTS_
+#undef X
+      kCorpusMixCount,
+} CorpusMix;
+
+extern const char* const kCorpusMixNames[];
+
+// Generates at least `size` bytes of Pascal whose token mix is skewed
+// towards `mix`. The same seed always produces the same text.
+String CorpusGenerate(CorpusMix mix, uint64_t size, uint64_t seed);
@@ -0,0 +1,258 @@
+#include <pas/lex.h>
+#include <pas/scan.h>
+#include <pas/source.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+
+#include "corpus.h"
+#include "verify.h"
+
+typedef struct {
+  CorpusMix mix;
+  bool all_mixes;
+  uint64_t size;
+  uint64_t seed;
+  uint32_t iterations;
+  uint32_t threads;
+  bool verify;
+  bool intern;
+  const char* dump;
+} BenchOptions;
+
+// Bytes held by the lexer's vecs now and at most, which unlike the process's
+// peak RSS can be reported for each mix on its own.
+typedef struct {
+  uint64_t allocations;
+  uint64_t live_bytes;
+  uint64_t peak_bytes;
+} AllocationCounts;
+
+static bool ParseOptions(int argc, char** argv, BenchOptions* options);
+static bool ParseMix(const char* text, BenchOptions* options);
+static bool BenchMix(const BenchOptions* options, CorpusMix mix);
+static bool Verify(const PasSource* source,
+                   const PasTokenStream* expected,
+                   const BenchOptions* options);
+static bool SameTokens(const PasTokenStream* a, const PasTokenStream* b);
+static void* CountingReallocate(void* context,
+                                void* ptr,
+                                uint64_t old_size,
+                                uint64_t new_size);
+static void CountingRelease(void* context, void* ptr, uint64_t size);
+static double Now(void);
+static void Usage(const char* program);
+
+int main(int argc, char** argv) {
+  BenchOptions options = {
+      .mix = kCorpusMixMixed,
+      .size = 64ull * 1024 * 1024,
+      .seed = 1,
+      .iterations = 5,
+  };
+  if (!ParseOptions(argc, argv, &options)) {
+    Usage(argv[0]);
+    return 1;
+  }
+  bool ok = !options.verify || VerifyAll();
+  printf("%-12s %8s %9s %9s %10s %10s\n", "mix", "MiB", "MiB/s", "Mtok/s",
+         "allocs/tok", "peak KiB");
+  for (int mix = 0; mix < kCorpusMixCount; ++mix) {
+    if (options.all_mixes || mix == (int)options.mix) {
+      ok = BenchMix(&options, (CorpusMix)mix) && ok;
+    }
+  }
+  return ok ? 0 : 1;
+}
+
+bool ParseOptions(int argc, char** argv, BenchOptions* options) {
+  for (int i = 1; i < argc; ++i) {
+    const char* arg = argv[i];
+    const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+    if (strcmp(arg, "--verify") == 0) {
+      options->verify = true;
+      continue;
+    }
+    if (strcmp(arg, "--intern") == 0) {
+      options->intern = true;
+      continue;
+    }
+    if (value == NULL) {
+      return false;
+    }
+    ++i;
+    if (strcmp(arg, "--mix") == 0) {
+      if (!ParseMix(value, options)) {
+        return false;
+      }
+    } else if (strcmp(arg, "--size") == 0) {
+      options->size = strtoull(value, NULL, 10) * 1024 * 1024;
+    } else if (strcmp(arg, "--seed") == 0) {
+      options->seed = strtoull(value, NULL, 10);
+    } else if (strcmp(arg, "--iterations") == 0) {
+      options->iterations = (uint32_t)strtoul(value, NULL, 10);
+    } else if (strcmp(arg, "--threads") == 0) {
+      options->threads = (uint32_t)strtoul(value, NULL, 10);
+    } else if (strcmp(arg, "--dump") == 0) {
+      options->dump = value;
+    } else {
+      return false;
+    }
+  }
+  return options->size > 0 && options->iterations > 0;
+}
+
+bool ParseMix(const char* text, BenchOptions* options) {
+  if (strcasecmp(text, "all") == 0) {
+    options->all_mixes = true;
+    return true;
+  }
+  for (int mix = 0; mix < kCorpusMixCount; ++mix) {
+    if (strcasecmp(text, kCorpusMixNames[mix]) == 0) {
+      options->mix = (CorpusMix)mix;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool BenchMix(const BenchOptions* options, CorpusMix mix) {
+  String text = CorpusGenerate(mix, options->size, options->seed);
+  if (options->dump != NULL) {
+    FILE* fp = fopen(options->dump, "w");
+    if (fp != NULL) {
+      fwrite(text.data, 1, text.size, fp);
+      fclose(fp);
+    }
+  }
+  PasSource source;
+  if (!PasSourceFromMemory(&source, text.data, text.size)) {
+    VEC_FREE(&text);
+    return false;
+  }
+  VEC_FREE(&text);
+  AllocationCounts counts = {0};
+  VecAllocator counting = {
+      .reallocate = CountingReallocate,
+      .release = CountingRelease,
+      .context = &counts,
+  };
+  PasLexOptions lex_options = {
+      .allocator = &counting,
+      .threads = options->threads,
+  };
+  double best = 0;
+  uint64_t tokens = 0;
+  bool ok = true;
+  for (uint32_t i = 0; i < options->iterations; ++i) {
+    counts = (AllocationCounts){0};
+    PasInterner interner;
+    PasInternerInit(&interner, &counting);
+    lex_options.interner = options->intern ? &interner : NULL;
+    double start = Now();
+    PasTokenStream stream = PasLexWithOptions(&source, &lex_options);
+    double elapsed = Now() - start;
+    if (i == 0 || elapsed < best) {
+      best = elapsed;
+    }
+    tokens = PasTokenStreamSize(&stream);
+    if (i == 0 && options->verify) {
+      ok = Verify(&source, &stream, options);
+    }
+    PasTokenStreamFree(&stream);
+    PasInternerFree(&interner);
+  }
+  double mib = (double)source.size / (1024.0 * 1024.0);
+  printf("%-12s %8.1f %9.1f %9.2f %10.5f %10llu%s\n", kCorpusMixNames[mix],
+         mib, mib / best, (double)tokens / best / 1e6,
+         tokens == 0 ? 0.0 : (double)counts.allocations / (double)tokens,
+         (unsigned long long)(counts.peak_bytes / 1024),
+         ok ? "" : "  MISMATCH");
+  PasSourceClose(&source);
+  return ok;
+}
+
+// Re-lexes with the scalar kernels and with the parallel lexer and checks
+// that both match `expected` token for token.
+bool Verify(const PasSource* source,
+            const PasTokenStream* expected,
+            const BenchOptions* options) {
+  PasTokenStream scalar;
+  PasTokenStreamInit(&scalar, expected->wide, NULL);
+  PasLexer lexer;
+  PasLexerInit(&lexer, source);
+  lexer.scan = PasScanKernelsFor(kPasScanLevelScalar);
+  PasToken token;
+  while (PasLexerNext(&lexer, &token)) {
+    PasTokenStreamPush(&scalar, &token);
+  }
+  PasLexerFinish(&lexer);
+  bool ok = SameTokens(expected, &scalar);
+  PasTokenStreamFree(&scalar);
+  PasTokenStream parallel = PasLexParallel(
+      source,
+      &(PasLexOptions){.threads = options->threads > 1 ? options->threads : 8});
+  ok = SameTokens(expected, &parallel) && ok;
+  PasTokenStreamFree(&parallel);
+  return ok;
+}
+
+bool SameTokens(const PasTokenStream* a, const PasTokenStream* b) {
+  if (PasTokenStreamSize(a) != PasTokenStreamSize(b)) {
+    return false;
+  }
+  for (uint64_t i = 0; i < PasTokenStreamSize(a); ++i) {
+    PasToken x = PasTokenStreamGet(a, i);
+    PasToken y = PasTokenStreamGet(b, i);
+    if (x.type != y.type || x.position != y.position ||
+        x.length != y.length) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void* CountingReallocate(void* context,
+                         void* ptr,
+                         uint64_t old_size,
+                         uint64_t new_size) {
+  AllocationCounts* counts = context;
+  void* result = realloc(ptr, new_size);
+  if (result != NULL) {
+    counts->allocations++;
+    counts->live_bytes = counts->live_bytes - old_size + new_size;
+    if (counts->live_bytes > counts->peak_bytes) {
+      counts->peak_bytes = counts->live_bytes;
+    }
+  }
+  return result;
+}
+
+void CountingRelease(void* context, void* ptr, uint64_t size) {
+  AllocationCounts* counts = context;
+  counts->live_bytes -= size;
+  free(ptr);
+}
+
+double Now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+void Usage(const char* program) {
+  fprintf(stderr,
+          "usage: %s [--mix NAME|all] [--size MiB] [--seed N] "
+          "[--iterations N]\n"
+          "       [--threads N] [--verify] [--intern] [--dump FILE]\n",
+          program);
+  fprintf(stderr, "mixes:");
+  for (int mix = 0; mix < kCorpusMixCount; ++mix) {
+    fprintf(stderr, " %s", kCorpusMixNames[mix]);
+  }
+  fprintf(stderr, "\n");
+}
@@ -0,0 +1,457 @@
+#include "verify.h"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <pas/lex.h>
+#include <pas/number.h>
+#include <pas/scan.h>
+#include <pas/source.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Stop bytes go at every offset up to this from every start alignment below
+// VERIFY_SCAN_ALIGNMENTS, which crosses the 16- and 32-byte vector widths.
+#define VERIFY_SCAN_OFFSETS 64
+#define VERIFY_SCAN_ALIGNMENTS 32
+#define VERIFY_SCAN_TAIL 64
+// Generated literals per kind of number.
+#define VERIFY_NUMBER_CASES 100000
+// Texts to edit, edits per text, and the most bytes a text grows to.
+#define VERIFY_RELEX_TEXTS 2000
+#define VERIFY_RELEX_EDITS 20
+#define VERIFY_RELEX_SIZE 2048
+
+typedef struct {
+  const char* name;
+  bool (*run)(void);
+} VerifyCheck;
+
+typedef struct {
+  const char* name;
+  size_t offset;
+  // Bytes that continue the run, cycled to fill the text around the stop.
+  const char* filler;
+} ScanKernelCase;
+
+static const ScanKernelCase kScanKernelCases[] = {
+    {"whitespace", offsetof(PasScanKernels, whitespace), " \t\n\r"},
+    {"identifier", offsetof(PasScanKernels, identifier), "aZz09_"},
+    {"brace_comment", offsetof(PasScanKernels, brace_comment), "x*\n{"},
+    {"paren_comment", offsetof(PasScanKernels, paren_comment), "x)}(\n"},
+    {"quote", offsetof(PasScanKernels, quote), "x\"}*"},
+};
+
+// Literals that are easy to get wrong, checked before the generated ones.
+static const char* const kNumberEdges[] = {
+    "0",
+    "00000000000000000000000000",
+    "18446744073709551615",
+    "18446744073709551616",
+    "99999999999999999999",
+    "000000000000000000018446744073709551615",
+    "9007199254740992",
+    "9007199254740993",
+    "9007199254740994.5",
+    "1e22",
+    "1e23",
+    "0.1",
+    "123456789012345678901234567890",
+    "1e308",
+    "1.7976931348623157e308",
+    "1.7976931348623158e308",
+    "1.7976931348623159e308",
+    "1e309",
+    "1e400",
+    "1e99999999999",
+    "2.2250738585072011e-308",
+    "2.2250738585072014e-308",
+    "4.9406564584124654e-324",
+    "2.4703282292062327e-324",
+    "2.4703282292062328e-324",
+    "1e-324",
+    "1e-400",
+    "1e-99999999999",
+    "0e99999",
+    "0.000000000000000000000000000000000000000001e42",
+    "7.2057594037927933e16",
+    "1E+5",
+    "1e-5",
+};
+
+// Edits are made of these, so that they open, close and split strings,
+// comments and numbers such as 1e+5.
+static const char* const kRelexPieces[] = {
+    "begin", "end", "x", "x1", "  ", "\n", "{ c }", "(* c *)", "{", "}",
+    "(*", "*)", "*", ")", "(", "'s'", "'it''s'", "'", "1", "1e+5", "1.5",
+    "e", "+", "-", ".", "..", ":=", ";", "12", "0",
+};
+
+static bool VerifyScanKernels(void);
+static bool VerifyScanKernel(const PasScanKernels* kernels,
+                             const ScanKernelCase* test);
+static PasScanKernel KernelAt(const PasScanKernels* kernels, size_t offset);
+static bool VerifyRelex(void);
+static bool VerifyRelexText(uint64_t* state, PasInterner* interner);
+static uint64_t AppendPieces(uint64_t* state,
+                             char* text,
+                             uint64_t count,
+                             uint64_t room);
+static bool TokensEqual(const PasTokenStream* a, const PasTokenStream* b);
+static bool VerifyNumbers(void);
+static bool VerifyNumber(const char* text);
+static void GenerateInt(uint64_t* state, char* text);
+static void GenerateReal(uint64_t* state, char* text);
+static void GenerateHalfway(uint64_t* state, char* text);
+static char* WriteDigits(char* p, unsigned __int128 value);
+static uint64_t NextRandom(uint64_t* state);
+
+static const VerifyCheck kVerifyChecks[] = {
+    {"scan kernels", VerifyScanKernels},
+    {"numbers", VerifyNumbers},
+    {"relex", VerifyRelex},
+};
+
+bool VerifyAll(void) {
+  bool ok = true;
+  for (size_t i = 0; i < sizeof(kVerifyChecks) / sizeof(VerifyCheck); ++i) {
+    bool passed = kVerifyChecks[i].run();
+    printf("%-12s %s\n", kVerifyChecks[i].name, passed ? "ok" : "FAILED");
+    ok = ok && passed;
+  }
+  return ok;
+}
+
+bool VerifyScanKernels(void) {
+  for (int level = kPasScanLevelScalar + 1; level <= kPasScanLevelAvx2;
+       ++level) {
+    const PasScanKernels* kernels = PasScanKernelsFor((PasScanLevel)level);
+    if (kernels == NULL) {
+      continue;
+    }
+    for (size_t i = 0; i < sizeof(kScanKernelCases) / sizeof(ScanKernelCase);
+         ++i) {
+      if (!VerifyScanKernel(kernels, &kScanKernelCases[i])) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Puts every byte value at every offset from every alignment, once with more
+// of the run after it and once as the last byte before the NUL padding.
+bool VerifyScanKernel(const PasScanKernels* kernels,
+                      const ScanKernelCase* test) {
+  enum {
+    kSize = VERIFY_SCAN_ALIGNMENTS + VERIFY_SCAN_OFFSETS + VERIFY_SCAN_TAIL,
+  };
+  _Alignas(64) char buffer[kSize + PAS_SOURCE_PADDING];
+  PasScanKernel vector = KernelAt(kernels, test->offset);
+  PasScanKernel scalar =
+      KernelAt(PasScanKernelsFor(kPasScanLevelScalar), test->offset);
+  size_t filler_length = strlen(test->filler);
+  for (uint64_t i = 0; i < kSize; ++i) {
+    buffer[i] = test->filler[i % filler_length];
+  }
+  memset(buffer + kSize, 0, PAS_SOURCE_PADDING);
+  for (int byte = 0; byte < 256; ++byte) {
+    for (int align = 0; align < VERIFY_SCAN_ALIGNMENTS; ++align) {
+      for (int offset = 0; offset < VERIFY_SCAN_OFFSETS; ++offset) {
+        for (int last = 0; last < 2; ++last) {
+          uint64_t stop = (uint64_t)(align + offset);
+          char saved[PAS_SOURCE_PADDING];
+          memcpy(saved, buffer + stop, sizeof(saved));
+          if (last) {
+            memset(buffer + stop + 1, 0, sizeof(saved) - 1);
+          }
+          buffer[stop] = (char)byte;
+          const char* begin = buffer + align;
+          const char* got = vector(begin);
+          const char* want = scalar(begin);
+          memcpy(buffer + stop, saved, sizeof(saved));
+          if (got != want) {
+            fprintf(stderr,
+                    "%s %s: byte 0x%02x at offset %d from alignment %d%s "
+                    "stops at %td, scalar at %td\n",
+                    kernels->name, test->name, byte, offset, align,
+                    last ? " before the padding" : "", got - begin,
+                    want - begin);
+            return false;
+          }
+        }
+      }
+    }
+  }
+  return true;
+}
+
+PasScanKernel KernelAt(const PasScanKernels* kernels, size_t offset) {
+  return *(const PasScanKernel*)((const char*)kernels + offset);
+}
+
+// Edits random texts over and over, and after each edit compares PasRelex of
+// the old tokens with PasLexWithOptions of the new text.
+bool VerifyRelex(void) {
+  uint64_t state = 1;
+  for (int i = 0; i < VERIFY_RELEX_TEXTS; ++i) {
+    PasInterner interner;
+    PasInternerInit(&interner, NULL);
+    bool ok = VerifyRelexText(&state, i % 2 == 0 ? &interner : NULL);
+    PasInternerFree(&interner);
+    if (!ok) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Edits start at offset 0, at the end, or inside a token, which is where
+// strings, comments and numbers get split.
+bool VerifyRelexText(uint64_t* state, PasInterner* interner) {
+  char text[VERIFY_RELEX_SIZE];
+  uint64_t size = AppendPieces(state, text, 20 + NextRandom(state) % 40,
+                               sizeof(text));
+  PasLexOptions options = {.interner = interner};
+  PasSource source;
+  if (!PasSourceFromMemory(&source, text, size)) {
+    return false;
+  }
+  PasTokenStream tokens = PasLexWithOptions(&source, &options);
+  PasSourceClose(&source);
+  bool ok = true;
+  for (int edit = 0; ok && edit < VERIFY_RELEX_EDITS; ++edit) {
+    uint64_t start = size;
+    uint64_t count = PasTokenStreamSize(&tokens);
+    uint64_t where = NextRandom(state) % 8;
+    if (where == 0 || count == 0) {
+      start = 0;
+    } else if (where > 1) {
+      uint64_t index = NextRandom(state) % count;
+      start = PasTokenStreamPosition(&tokens, index) +
+              NextRandom(state) % PasTokenStreamLength(&tokens, index);
+    }
+    uint64_t removed = NextRandom(state) % 8;
+    if (removed > size - start) {
+      removed = size - start;
+    }
+    char inserted[VERIFY_RELEX_SIZE];
+    uint64_t inserted_size =
+        AppendPieces(state, inserted, NextRandom(state) % 4,
+                     sizeof(text) - (size - removed));
+    char before[VERIFY_RELEX_SIZE];
+    memcpy(before, text, size);
+    memmove(text + start + inserted_size, text + start + removed,
+            size - start - removed);
+    memcpy(text + start, inserted, inserted_size);
+    size = size - removed + inserted_size;
+    if (!PasSourceFromMemory(&source, text, size)) {
+      ok = false;
+      break;
+    }
+    PasTokenStream want = PasLexWithOptions(&source, &options);
+    ok = PasRelex(&tokens, &source, start, removed, inserted_size) &&
+         TokensEqual(&tokens, &want);
+    if (!ok) {
+      fprintf(stderr,
+              "relex of \"%.*s\" replacing %" PRIu64 " bytes at %" PRIu64
+              " with \"%.*s\" differs from lexing \"%.*s\"\n",
+              (int)(size - inserted_size + removed), before, removed, start,
+              (int)inserted_size, inserted, (int)size, text);
+    }
+    PasTokenStreamFree(&want);
+    PasSourceClose(&source);
+  }
+  PasTokenStreamFree(&tokens);
+  return ok;
+}
+
+// Appends up to `count` random pieces that fit in `room` bytes and returns
+// the bytes written.
+uint64_t AppendPieces(uint64_t* state,
+                      char* text,
+                      uint64_t count,
+                      uint64_t room) {
+  uint64_t size = 0;
+  for (uint64_t i = 0; i < count; ++i) {
+    const char* piece = kRelexPieces[NextRandom(state) % (sizeof(kRelexPieces) /
+                                                          sizeof(char*))];
+    uint64_t length = strlen(piece);
+    if (size + length > room) {
+      break;
+    }
+    memcpy(text + size, piece, length);
+    size += length;
+  }
+  return size;
+}
+
+bool TokensEqual(const PasTokenStream* a, const PasTokenStream* b) {
+  if (PasTokenStreamSize(a) != PasTokenStreamSize(b)) {
+    return false;
+  }
+  for (uint64_t i = 0; i < PasTokenStreamSize(a); ++i) {
+    PasToken x = PasTokenStreamGet(a, i);
+    PasToken y = PasTokenStreamGet(b, i);
+    if (x.position != y.position || x.length != y.length ||
+        x.type != y.type || x.symbol != y.symbol) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Compares PasTokenInt and PasTokenReal, on the token PasLex makes of each
+// literal, with strtoull and strtod.
+bool VerifyNumbers(void) {
+  for (size_t i = 0; i < sizeof(kNumberEdges) / sizeof(char*); ++i) {
+    if (!VerifyNumber(kNumberEdges[i])) {
+      return false;
+    }
+  }
+  void (*const generators[])(uint64_t*, char*) = {
+      GenerateInt,
+      GenerateReal,
+      GenerateHalfway,
+  };
+  uint64_t state = 1;
+  for (size_t g = 0; g < sizeof(generators) / sizeof(generators[0]); ++g) {
+    for (int i = 0; i < VERIFY_NUMBER_CASES; ++i) {
+      char text[128];
+      generators[g](&state, text);
+      if (!VerifyNumber(text)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool VerifyNumber(const char* text) {
+  PasSource source;
+  if (!PasSourceFromMemory(&source, text, strlen(text))) {
+    return false;
+  }
+  PasTokenStream tokens = PasLex(&source);
+  StringView view = PasSourceView(&source);
+  PasToken token = PasTokenStreamGet(&tokens, 0);
+  bool lexed = PasTokenStreamSize(&tokens) == 1 &&
+               (token.type == kPasTokenTypeNumInt ||
+                token.type == kPasTokenTypeNumReal);
+  bool ok = lexed;
+  if (lexed && token.type == kPasTokenTypeNumInt) {
+    errno = 0;
+    uint64_t want = strtoull(text, NULL, 10);
+    bool fits = errno != ERANGE;
+    uint64_t got = 0;
+    bool parsed = PasTokenInt(view, &token, &got);
+    ok = parsed == fits && (!fits || got == want);
+    if (!ok) {
+      fprintf(stderr,
+              "%s: PasTokenInt gives %s%" PRIu64 ", strtoull %s%" PRIu64 "\n",
+              text, parsed ? "" : "failure ", got, fits ? "" : "overflow ",
+              want);
+    }
+  }
+  if (lexed) {
+    double want = strtod(text, NULL);
+    double got = 0;
+    bool parsed = PasTokenReal(view, &token, &got);
+    ok = ok && parsed && memcmp(&got, &want, sizeof(double)) == 0;
+    if (!parsed || memcmp(&got, &want, sizeof(double)) != 0) {
+      fprintf(stderr, "%s: PasTokenReal gives %a, strtod %a\n", text, got,
+              want);
+    }
+  } else {
+    fprintf(stderr, "%s: not lexed as a single number\n", text);
+  }
+  PasTokenStreamFree(&tokens);
+  PasSourceClose(&source);
+  return ok;
+}
+
+// 1 to 25 digits, often with leading zeros, so that 19- and 20-digit values
+// on both sides of 2^64 are common.
+void GenerateInt(uint64_t* state, char* text) {
+  char* p = text;
+  uint64_t zeros = NextRandom(state) % 4 == 0 ? NextRandom(state) % 8 : 0;
+  for (uint64_t i = 0; i < zeros; ++i) {
+    *p++ = '0';
+  }
+  uint64_t digits = 1 + NextRandom(state) % 25;
+  if (NextRandom(state) % 2 == 0) {
+    digits = 19 + NextRandom(state) % 2;
+  }
+  for (uint64_t i = 0; i < digits; ++i) {
+    *p++ = (char)('0' + NextRandom(state) % 10);
+  }
+  *p = '\0';
+}
+
+// Up to 25 mantissa digits split around an optional point, with an exponent
+// that reaches past both ends of the double range and into the subnormals.
+void GenerateReal(uint64_t* state, char* text) {
+  char* p = text;
+  uint64_t digits = 1 + NextRandom(state) % 25;
+  uint64_t point = NextRandom(state) % (digits + 1);
+  for (uint64_t i = 0; i < digits; ++i) {
+    if (i == point && i > 0) {
+      *p++ = '.';
+    }
+    *p++ = (char)('0' + NextRandom(state) % 10);
+  }
+  int64_t exponent;
+  switch (NextRandom(state) % 4) {
+    case 0:
+      exponent = (int64_t)(NextRandom(state) % 45) - 22;
+      break;
+    case 1:
+      exponent = -(int64_t)(300 + NextRandom(state) % 50);
+      break;
+    case 2:
+      exponent = (int64_t)(290 + NextRandom(state) % 30);
+      break;
+    default:
+      exponent = (int64_t)(NextRandom(state) % 700) - 350;
+      break;
+  }
+  sprintf(p, "%c%+" PRId64, NextRandom(state) % 2 ? 'e' : 'E', exponent);
+}
+
+// A 54-bit odd integer lies exactly halfway between two doubles, and so does
+// its quotient by a power of two, which is written out exactly as the
+// integer times the same power of five with the point moved.
+void GenerateHalfway(uint64_t* state, char* text) {
+  uint64_t halfway = (NextRandom(state) >> 10) | (1ull << 53) | 1;
+  uint64_t shift = NextRandom(state) % 28;
+  unsigned __int128 scaled = halfway;
+  for (uint64_t i = 0; i < shift; ++i) {
+    scaled *= 5;
+  }
+  char* p = WriteDigits(text, scaled);
+  sprintf(p, "e-%" PRIu64, shift);
+}
+
+char* WriteDigits(char* p, unsigned __int128 value) {
+  char digits[40];
+  int count = 0;
+  do {
+    digits[count++] = (char)('0' + (int)(value % 10));
+    value /= 10;
+  } while (value != 0);
+  while (count > 0) {
+    *p++ = digits[--count];
+  }
+  return p;
+}
+
+// splitmix64, so that every run checks the same literals.
+uint64_t NextRandom(uint64_t* state) {
+  uint64_t z = (*state += 0x9E3779B97F4A7C15ull);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+  return z ^ (z >> 31);
+}
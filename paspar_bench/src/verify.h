@@ -0,0 +1,8 @@
+#pragma once
+
+#include <stdbool.h>
+
+// Runs the self-checks of --verify: each library component against a
+// simpler or standard implementation of the same thing. Prints a line per
+// check and the first mismatch of each to stderr.
+bool VerifyAll(void);
@@ -3,18 +3,32 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+// Optional allocator for a vec. A vec whose allocator is NULL uses
+// realloc/free. `reallocate` receives the old and new sizes in bytes so that
+// allocators without per-block headers can move blocks.
+typedef struct {
+  void* (*reallocate)(void* context,
+                      void* ptr,
+                      uint64_t old_size,
+                      uint64_t new_size);
+  void (*release)(void* context, void* ptr, uint64_t size);
+  void* context;
+} VecAllocator;
+
 typedef struct {
   uint8_t** data;
   uint64_t* size;
   uint64_t* capacity;
   uint64_t sizeof_t;
+  const VecAllocator* allocator;
 } VecUnpacked;
 
-#define VEC_TYPE(T)    \
-  struct {             \
-    T* data;           \
-    uint64_t size;     \
-    uint64_t capacity; \
+#define VEC_TYPE(T)                \
+  struct {                         \
+    T* data;                       \
+    uint64_t size;                 \
+    uint64_t capacity;             \
+    const VecAllocator* allocator; \
   }
 
 #define VEC_UNPACK(V)        \
@@ -23,18 +37,19 @@ typedef struct {
       &(V)->size,            \
       &(V)->capacity,        \
       sizeof(*(V)->data),    \
+      (V)->allocator,        \
   })
 
-#define VEC_FREE(V)    \
-  do {                 \
-    free((V)->data);   \
-    (V)->data = NULL;  \
-    (V)->size = 0;     \
-    (V)->capacity = 0; \
-  } while (false)
+// Must be called while the vec holds no storage.
+#define VEC_SET_ALLOCATOR(V, Allocator) ((V)->allocator = (Allocator))
+
+#define VEC_FREE(V) VecFree(VEC_UNPACK(V))
 
-#define VEC_PUSH(V, Value) \
-  (VecExpand(VEC_UNPACK(V)) ? ((V)->data[(V)->size++] = (Value), true) : false)
+// Only a full vec calls out to VecExpand.
+#define VEC_PUSH(V, Value)                                  \
+  (((V)->size < (V)->capacity || VecExpand(VEC_UNPACK(V))) \
+       ? ((V)->data[(V)->size++] = (Value), true)           \
+       : false)
 
 #define VEC_POP(V) (V)->data[--(V)->size]
 
@@ -45,3 +60,4 @@ typedef struct {
 bool VecExpand(VecUnpacked v);
 bool VecReserve(VecUnpacked v, uint64_t amount);
 bool VecAppend(VecUnpacked v, const void* data, uint64_t size);
+void VecFree(VecUnpacked v);
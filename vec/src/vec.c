@@ -3,17 +3,38 @@
 #include <stdlib.h>
 #include <string.h>
 
+// Full vecs grow by VEC_GROWTH_NUM / VEC_GROWTH_DEN, to no less than
+// VEC_MIN_CAPACITY elements. The CMake options of the same names set them.
+#ifndef VEC_GROWTH_NUM
+#define VEC_GROWTH_NUM 2
+#endif
+#ifndef VEC_GROWTH_DEN
+#define VEC_GROWTH_DEN 1
+#endif
+#ifndef VEC_MIN_CAPACITY
+#define VEC_MIN_CAPACITY 8
+#endif
+_Static_assert(VEC_GROWTH_NUM > VEC_GROWTH_DEN && VEC_GROWTH_DEN > 0 &&
+                   VEC_MIN_CAPACITY > 0,
+               "vecs must grow by a factor above 1 from a nonzero capacity");
+
+static uint64_t VecGrownCapacity(uint64_t capacity, uint64_t needed);
+
 bool VecExpand(VecUnpacked v) {
   if (*v.size + 1 > *v.capacity) {
-    uint64_t n = (*v.capacity == 0) ? 1 : *v.capacity * 2;
-    return VecReserve(v, n);
+    return VecReserve(v, VecGrownCapacity(*v.capacity, *v.size + 1));
   }
   return true;
 }
 
 bool VecReserve(VecUnpacked v, uint64_t amount) {
   if (*v.capacity < amount) {
-    void* ptr = realloc(*v.data, amount * v.sizeof_t);
+    void* ptr =
+        v.allocator == NULL
+            ? realloc(*v.data, amount * v.sizeof_t)
+            : v.allocator->reallocate(v.allocator->context, *v.data,
+                                      *v.capacity * v.sizeof_t,
+                                      amount * v.sizeof_t);
     if (ptr == NULL) {
       return false;
     }
@@ -24,10 +45,34 @@ bool VecReserve(VecUnpacked v, uint64_t amount) {
 }
 
 bool VecAppend(VecUnpacked v, const void* data, uint64_t size) {
-  if (!VecReserve(v, *v.size + size)) {
+  // Grow geometrically so that repeated appends stay amortized O(1).
+  uint64_t needed = *v.size + size;
+  if (needed > *v.capacity &&
+      !VecReserve(v, VecGrownCapacity(*v.capacity, needed))) {
     return false;
   }
   memcpy(*v.data + *v.size * v.sizeof_t, data, size * v.sizeof_t);
   *v.size += size;
   return true;
 }
+
+void VecFree(VecUnpacked v) {
+  if (v.allocator == NULL) {
+    free(*v.data);
+  } else if (*v.data != NULL) {
+    v.allocator->release(v.allocator->context, *v.data,
+                         *v.capacity * v.sizeof_t);
+  }
+  *v.data = NULL;
+  *v.size = 0;
+  *v.capacity = 0;
+}
+
+uint64_t VecGrownCapacity(uint64_t capacity, uint64_t needed) {
+  uint64_t grown = capacity / VEC_GROWTH_DEN * VEC_GROWTH_NUM +
+                   capacity % VEC_GROWTH_DEN * VEC_GROWTH_NUM / VEC_GROWTH_DEN;
+  if (grown < VEC_MIN_CAPACITY) {
+    grown = VEC_MIN_CAPACITY;
+  }
+  return grown > needed ? grown : needed;
+}